@@ -4,9 +4,139 @@
 #include "UObject/UActor.h"
 #include "Math/floating.h"
 
+const CollisionCell* CollisionCellMap::Find(uint32_t id) const
+{
+	if (NumCells == 0)
+		return nullptr;
+
+	size_t mask = Cells.size() - 1;
+	for (size_t slot = GetHomeSlot(id);; slot = (slot + 1) & mask)
+	{
+		const CollisionCell& cell = Cells[slot];
+		if (cell.Id == id)
+			return &cell;
+		else if (cell.Id == CollisionCell::EmptyId)
+			return nullptr;
+	}
+}
+
+void CollisionCellMap::Add(uint32_t id, UActor* actor)
+{
+	if ((NumCells + 1) * 2 > Cells.size())
+		Grow();
+
+	size_t mask = Cells.size() - 1;
+	size_t slot = GetHomeSlot(id);
+	while (Cells[slot].Id != id && Cells[slot].Id != CollisionCell::EmptyId)
+		slot = (slot + 1) & mask;
+
+	CollisionCell& cell = Cells[slot];
+	if (cell.Id == CollisionCell::EmptyId)
+	{
+		cell.Id = id;
+		NumCells++;
+	}
+
+	if (!cell.Overflow.empty())
+	{
+		cell.Overflow.push_back(actor);
+	}
+	else if (cell.Count == CollisionCell::InlineCapacity)
+	{
+		cell.Overflow.assign(cell.InlineActors, cell.InlineActors + cell.Count);
+		cell.Overflow.push_back(actor);
+	}
+	else
+	{
+		cell.InlineActors[cell.Count] = actor;
+	}
+	cell.Count++;
+}
+
+void CollisionCellMap::Remove(uint32_t id, UActor* actor)
+{
+	if (NumCells == 0)
+		return;
+
+	size_t mask = Cells.size() - 1;
+	size_t slot = GetHomeSlot(id);
+	while (Cells[slot].Id != id)
+	{
+		if (Cells[slot].Id == CollisionCell::EmptyId)
+			return;
+		slot = (slot + 1) & mask;
+	}
+
+	CollisionCell& cell = Cells[slot];
+	UActor** actors = cell.Overflow.empty() ? cell.InlineActors : cell.Overflow.data();
+	for (uint32_t i = 0; i < cell.Count; i++)
+	{
+		if (actors[i] == actor)
+		{
+			actors[i] = actors[cell.Count - 1];
+			cell.Count--;
+			if (!cell.Overflow.empty())
+				cell.Overflow.pop_back();
+			break;
+		}
+	}
+
+	if (cell.Count == 0)
+		EraseSlot(slot);
+}
+
+void CollisionCellMap::EraseSlot(size_t slot)
+{
+	// Backward shift deletion: move later entries of the probe chain into the hole so no tombstones are needed
+	size_t mask = Cells.size() - 1;
+	size_t hole = slot;
+	for (size_t next = (hole + 1) & mask; Cells[next].Id != CollisionCell::EmptyId; next = (next + 1) & mask)
+	{
+		size_t home = GetHomeSlot(Cells[next].Id);
+		bool canMove = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+		if (canMove)
+		{
+			Cells[hole] = std::move(Cells[next]);
+			hole = next;
+		}
+	}
+
+	CollisionCell& cell = Cells[hole];
+	cell.Id = CollisionCell::EmptyId;
+	cell.Count = 0;
+	cell.Overflow.clear();
+	NumCells--;
+}
+
+void CollisionCellMap::Grow()
+{
+	std::vector<CollisionCell> oldCells = std::move(Cells);
+	Cells.clear();
+	Cells.resize(std::max(oldCells.size() * 2, (size_t)256));
+
+	size_t mask = Cells.size() - 1;
+	for (CollisionCell& cell : oldCells)
+	{
+		if (cell.Id != CollisionCell::EmptyId)
+		{
+			size_t slot = GetHomeSlot(cell.Id);
+			while (Cells[slot].Id != CollisionCell::EmptyId)
+				slot = (slot + 1) & mask;
+			Cells[slot] = std::move(cell);
+		}
+	}
+}
+
+void CollisionCellMap::Clear()
+{
+	Cells.clear();
+	NumCells = 0;
+}
+
 void CollisionHash::AddToCollision(UActor* actor)
 {
-	if (actor->bCollideActors())
+	// Script can still move a destroyed actor, but it must stay out of the hash as it is freed soon
+	if (actor->bCollideActors() && !actor->bDeleteMe())
 	{
 		vec3 location = actor->Location();
 		float height = actor->CollisionHeight();
@@ -26,7 +156,7 @@ void CollisionHash::AddToCollision(UActor* actor)
 			{
 				for (int x = start.x; x < end.x; x++)
 				{
-					CollisionActors[GetBucketId(x, y, z)].push_back(actor);
+					CollisionActors.Add(GetBucketId(x, y, z), actor);
 				}
 			}
 		}
@@ -50,13 +180,7 @@ void CollisionHash::RemoveFromCollision(UActor* actor)
 			{
 				for (int x = start.x; x < end.x; x++)
 				{
-					auto it = CollisionActors.find(GetBucketId(x, y, z));
-					if (it != CollisionActors.end())
-					{
-						it->second.remove(actor);
-						if (it->second.empty())
-							CollisionActors.erase(it);
-					}
+					CollisionActors.Remove(GetBucketId(x, y, z), actor);
 				}
 			}
 		}
@@ -65,6 +189,64 @@ void CollisionHash::RemoveFromCollision(UActor* actor)
 	}
 }
 
+static bool IsInsideCells(int x, int y, int z, const ivec3& start, const ivec3& end)
+{
+	return x >= start.x && x < end.x && y >= start.y && y < end.y && z >= start.z && z < end.z;
+}
+
+void CollisionHash::UpdateCollision(UActor* actor)
+{
+	if (!actor->CollisionHashInfo.Inserted || !actor->bCollideActors() || actor->bDeleteMe())
+	{
+		RemoveFromCollision(actor);
+		AddToCollision(actor);
+		return;
+	}
+
+	vec3 oldLocation = actor->CollisionHashInfo.Location;
+	vec3 oldExtents = { actor->CollisionHashInfo.Radius, actor->CollisionHashInfo.Radius, actor->CollisionHashInfo.Height };
+	ivec3 oldStart = GetStartExtents(oldLocation, oldExtents);
+	ivec3 oldEnd = GetEndExtents(oldLocation, oldExtents);
+
+	vec3 location = actor->Location();
+	float height = actor->CollisionHeight();
+	float radius = actor->CollisionRadius();
+	vec3 extents = { radius, radius, height };
+	ivec3 start = GetStartExtents(location, extents);
+	ivec3 end = GetEndExtents(location, extents);
+
+	actor->CollisionHashInfo.Location = location;
+	actor->CollisionHashInfo.Height = height;
+	actor->CollisionHashInfo.Radius = radius;
+
+	if (start == oldStart && end == oldEnd)
+		return;
+
+	for (int z = oldStart.z; z < oldEnd.z; z++)
+	{
+		for (int y = oldStart.y; y < oldEnd.y; y++)
+		{
+			for (int x = oldStart.x; x < oldEnd.x; x++)
+			{
+				if (!IsInsideCells(x, y, z, start, end))
+					CollisionActors.Remove(GetBucketId(x, y, z), actor);
+			}
+		}
+	}
+
+	for (int z = start.z; z < end.z; z++)
+	{
+		for (int y = start.y; y < end.y; y++)
+		{
+			for (int x = start.x; x < end.x; x++)
+			{
+				if (!IsInsideCells(x, y, z, oldStart, oldEnd))
+					CollisionActors.Add(GetBucketId(x, y, z), actor);
+			}
+		}
+	}
+}
+
 double CollisionHash::RaySphereTrace(const dvec3& rayOrigin, double tmin, const dvec3& rayDirNormalized, double tmax, const dvec3& sphereCenter, double sphereRadius)
 {
 	dvec3 l = sphereCenter - rayOrigin;
@@ -463,10 +645,10 @@ std::vector<UActor*> CollisionHash::CollidingActors(const vec3& origin, float ra
 			{
 				for (int x = start.x; x < end.x; x++)
 				{
-					auto it = CollisionActors.find(GetBucketId(x, y, z));
-					if (it != CollisionActors.end())
+					const CollisionCell* cell = CollisionActors.Find(GetBucketId(x, y, z));
+					if (cell)
 					{
-						for (UActor* actor : it->second)
+						for (UActor* actor : *cell)
 						{
 							if (SphereActorOverlap(dorigin, dradius, actor))
 								hits.push_back(actor);
@@ -518,10 +700,10 @@ std::vector<UActor*> CollisionHash::CollidingActors(const vec3& origin, float he
 			{
 				for (int x = start.x; x < end.x; x++)
 				{
-					auto it = CollisionActors.find(GetBucketId(x, y, z));
-					if (it != CollisionActors.end())
+					const CollisionCell* cell = CollisionActors.Find(GetBucketId(x, y, z));
+					if (cell)
 					{
-						for (UActor* actor : it->second)
+						for (UActor* actor : *cell)
 						{
 							if (CylinderActorOverlap(dorigin, dheight, dradius, actor))
 								hits.push_back(actor);
@@ -1,19 +1,60 @@
 #pragma once
 
 #include "Math/vec.h"
-#include <unordered_map>
-#include <list>
 
 class UActor;
 
+// Actors overlapping a single 256x256x256 grid cell.
+// The first few actors are stored inline. A cell that runs out of inline space moves all its actors to the overflow vector.
+struct CollisionCell
+{
+	enum { InlineCapacity = 6, EmptyId = 0xffffffff };
+
+	uint32_t Id = EmptyId;
+	uint32_t Count = 0;
+	UActor* InlineActors[InlineCapacity];
+	std::vector<UActor*> Overflow;
+
+	UActor* const* begin() const { return Overflow.empty() ? InlineActors : Overflow.data(); }
+	UActor* const* end() const { return begin() + Count; }
+};
+
+// Open addressing (linear probing) hash table of the occupied grid cells
+class CollisionCellMap
+{
+public:
+	const CollisionCell* Find(uint32_t id) const;
+	void Add(uint32_t id, UActor* actor);
+	void Remove(uint32_t id, UActor* actor);
+	void Clear();
+
+	size_t Size() const { return NumCells; }
+
+private:
+	size_t GetHomeSlot(uint32_t id) const
+	{
+		uint32_t hash = id * 0x9e3779b1;
+		return (hash ^ (hash >> 15)) & (Cells.size() - 1);
+	}
+
+	void Grow();
+	void EraseSlot(size_t slot);
+
+	std::vector<CollisionCell> Cells;
+	size_t NumCells = 0;
+};
+
 class CollisionHash
 {
 public:
-	std::unordered_map<uint32_t, std::list<UActor*>> CollisionActors;
+	CollisionCellMap CollisionActors;
 
 	void AddToCollision(UActor* actor);
 	void RemoveFromCollision(UActor* actor);
 
+	// Updates the hash after the actor moved or changed its collision. Only cells the actor entered or left are touched.
+	void UpdateCollision(UActor* actor);
+
 	std::vector<UActor*> CollidingActors(const vec3& origin, float radius);
 	std::vector<UActor*> CollidingActors(const vec3& origin, float height, float radius);
 
@@ -82,6 +123,89 @@ public:
 		return ((x & 0x3ff) << 20) | ((y & 0x3ff) << 10) | (z & 0x3ff);
 	}
 
+	// Walks the cells touched by a box with the given extents swept from 'from' to 'to' (3D-DDA along the center line).
+	// Cells are visited once each, roughly in the order the sweep enters them. Return false from the callback to stop early.
+	template<typename Callback>
+	bool ForEachSweepCell(const vec3& from, const vec3& to, const vec3& extents, Callback&& callback) const
+	{
+		dvec3 origin = to_dvec3(from) * (1.0 / 256.0);
+		dvec3 target = to_dvec3(to) * (1.0 / 256.0);
+		dvec3 dir = target - origin;
+
+		ivec3 cell, last, step, border;
+		dvec3 tNext, tDelta;
+		for (int i = 0; i < 3; i++)
+		{
+			cell[i] = (int)std::floor(origin[i]);
+			last[i] = (int)std::floor(target[i]);
+			border[i] = (int)std::ceil(extents[i] * (1.0f / 256.0f));
+			if (dir[i] > 0.0)
+			{
+				step[i] = 1;
+				tDelta[i] = 1.0 / dir[i];
+				tNext[i] = (cell[i] + 1 - origin[i]) * tDelta[i];
+			}
+			else if (dir[i] < 0.0)
+			{
+				step[i] = -1;
+				tDelta[i] = -1.0 / dir[i];
+				tNext[i] = (origin[i] - cell[i]) * tDelta[i];
+			}
+			else
+			{
+				step[i] = 0;
+				tDelta[i] = 0.0;
+				tNext[i] = HUGE_VAL;
+			}
+		}
+
+		if (!VisitCells(cell - border, cell + border + 1, callback))
+			return false;
+
+		while (cell != last)
+		{
+			int axis = -1;
+			for (int i = 0; i < 3; i++)
+			{
+				if (cell[i] != last[i] && (axis == -1 || tNext[i] < tNext[axis]))
+					axis = i;
+			}
+
+			cell[axis] += step[axis];
+			tNext[axis] += tDelta[axis];
+
+			// Only the slab of cells on the leading face is new compared to the previous step
+			ivec3 start = cell - border;
+			ivec3 end = cell + border + 1;
+			if (step[axis] > 0)
+				start[axis] = end[axis] - 1;
+			else
+				end[axis] = start[axis] + 1;
+
+			if (!VisitCells(start, end, callback))
+				return false;
+		}
+		return true;
+	}
+
+	template<typename Callback>
+	bool VisitCells(const ivec3& start, const ivec3& end, Callback&& callback) const
+	{
+		for (int z = start.z; z < end.z; z++)
+		{
+			for (int y = start.y; y < end.y; y++)
+			{
+				for (int x = start.x; x < end.x; x++)
+				{
+					const CollisionCell* cell = CollisionActors.Find(GetBucketId(x, y, z));
+					if (cell && !callback(*cell))
+						return false;
+				}
+			}
+		}
+		return true;
+	}
+
 	// Ray/actor hit trace
 	static double RayActorTrace(const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, UActor* actor);
 
@@ -17,6 +17,16 @@ public:
 	BspNode* Node = nullptr;
 };
 
+// A single ray for the batched any-hit traces (ULevel::TraceRaysAnyHit)
+class TraceRayQuery
+{
+public:
+	vec3 From = vec3(0.0f);
+	vec3 To = vec3(0.0f);
+	UActor* TracingActor = nullptr;
+	bool Hit = false;
+};
+
 class CollisionHitList
 {
 public:
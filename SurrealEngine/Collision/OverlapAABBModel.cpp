@@ -12,36 +12,22 @@ CollisionHitList OverlapAABBModel::TestOverlap(UModel* model, const vec3& center
 
 void OverlapAABBModel::TestOverlap(const dvec3& center, const dvec3& extents, bool visibilityOnly, BspNode* node, CollisionHitList& hits)
 {
-	if (node->CollisionBound >= 0)
+	if (node->CollisionHull >= 0)
 	{
-		int32_t* hullIndexList = &Model->LeafHulls[node->CollisionBound];
-		int hullPlanesCount = 0;
-		while (hullIndexList[hullPlanesCount] >= 0)
-			hullPlanesCount++;
-
-		vec3* bboxStart = (vec3*)(&hullIndexList[hullPlanesCount + 1]);
-
-		BBox bbox;
-		bbox.min = bboxStart[0];
-		bbox.max = bboxStart[1];
+		const CollisionHull& hull = Model->CollisionHulls[node->CollisionHull];
 
 		BBox bbox2;
 		bbox2.min = to_vec3(center - extents);
 		bbox2.max = to_vec3(center + extents);
 
-		if (AABBOverlap(bbox, bbox2))
+		if (AABBOverlap(hull.Bounds, bbox2))
 		{
+			// The hull planes point out of the hull
+			const dvec4* planes = Model->CollisionPlanes.data() + hull.PlaneStart;
 			bool foundOutside = false;
-			for (int i = 0; i < hullPlanesCount; i++)
+			for (int i = 0; i < hull.PlaneCount; i++)
 			{
-				int32_t hullIndex = hullIndexList[i];
-				bool hullFlip = !!(hullIndex & 0x4000'0000);
-				hullIndex = hullIndex & ~0x4000'0000;
-				BspNode* hullnode = &Model->Nodes[hullIndex];
-				dvec4 hullplane((double)hullnode->PlaneX, (double)hullnode->PlaneY, (double)hullnode->PlaneZ, (double)hullnode->PlaneW);
-
-				int outsideside = hullFlip ? 1 : -1;
-				if (PlaneAABBOverlap(center, extents, hullplane) == outsideside)
+				if (PlaneAABBOverlap(center, extents, planes[i]) == -1)
 				{
 					foundOutside = true;
 					break;
@@ -30,10 +30,10 @@ CollisionHitList OverlapCylinderLevel::TestOverlap(ULevel* level, const vec3& lo
 				{
 					for (int x = start.x; x < end.x; x++)
 					{
-						auto it = Level->Hash.CollisionActors.find(Level->Hash.GetBucketId(x, y, z));
-						if (it != Level->Hash.CollisionActors.end())
+						const CollisionCell* cell = Level->Hash.CollisionActors.Find(Level->Hash.GetBucketId(x, y, z));
+						if (cell)
 						{
-							for (UActor* actor : it->second)
+							for (UActor* actor : *cell)
 							{
 								if (Level->Hash.CylinderActorOverlap(dlocation, dheight, dradius, actor))
 								{
@@ -13,18 +13,11 @@ CollisionHitList TraceAABBModel::Trace(UModel* model, const dvec3& origin, doubl
 
 void TraceAABBModel::Trace(const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, const dvec3& extents, bool visibilityOnly, BspNode* node, CollisionHitList& hits)
 {
-	if (node->CollisionBound >= 0)
+	if (node->CollisionHull >= 0)
 	{
-		int32_t* hullIndexList = &Model->LeafHulls[node->CollisionBound];
-		int hullPlanesCount = 0;
-		while (hullIndexList[hullPlanesCount] >= 0)
-			hullPlanesCount++;
+		const CollisionHull& hull = Model->CollisionHulls[node->CollisionHull];
 
-		vec3* bboxStart = (vec3*)(&hullIndexList[hullPlanesCount + 1]);
-
-		BBox bbox;
-		bbox.min = bboxStart[0];
-		bbox.max = bboxStart[1];
+		BBox bbox = hull.Bounds;
 
 		// Shave off part of the box, or ammo pickups can fall through the floor
 		float boxEpsilon = 0.1f;
@@ -34,18 +27,6 @@ void TraceAABBModel::Trace(const dvec3& origin, double tmin, const dvec3& dirNor
 		SweepCursor cursor(origin, dirNormalized, tmax, extents);
 		if (cursor.ClipBoxPlanes(bbox))
 		{
-			// Grab the hull planes and flip the plane direction if the plane points in the wrong direction.
-			std::vector<dvec4> planes;
-			for (int i = 0; i < hullPlanesCount; i++)
-			{
-				int32_t hullIndex = hullIndexList[i];
-				bool hullFlip = !!(hullIndex & 0x4000'0000);
-				hullIndex = hullIndex & ~0x4000'0000;
-				BspNode* hullnode = &Model->Nodes[hullIndex];
-				dvec4 hullplane((double)hullnode->PlaneX, (double)hullnode->PlaneY, (double)hullnode->PlaneZ, (double)hullnode->PlaneW);
-				planes.push_back(hullFlip ? -hullplane : hullplane);
-			}
-
 			// AABB/hull sweep test.
 			//
 			// This is the same as a ray/hull sweep test, except with extended and bevel planes so that it works for AABB.
@@ -55,9 +36,12 @@ void TraceAABBModel::Trace(const dvec3& origin, double tmin, const dvec3& dirNor
 			//
 			// We can sweep with an AABB instead of a ray by moving the planes outwards by the extents of the AABB. This will produce
 			// inaccuracies in the result, which we can reduce by adding bevel planes when the angle between the planes passes a threshold.
+			//
+			// The hull planes are followed by the bevel planes for the hull edges (see UModel::BuildCollisionHulls).
 
-			// Check for collision for each hull plane
-			for (int i = 0; i < hullPlanesCount; i++)
+			const dvec4* planes = Model->CollisionPlanes.data() + hull.PlaneStart;
+			int count = hull.PlaneCount + hull.BevelCount;
+			for (int i = 0; i < count; i++)
 			{
 				if (!cursor.ClipPlane(planes[i]))
 				{
@@ -65,29 +49,6 @@ void TraceAABBModel::Trace(const dvec3& origin, double tmin, const dvec3& dirNor
 				}
 			}
 
-			// Check for collision for any bevel plane we need to insert at the hull edges
-			for (int i = 0; i < hullPlanesCount; i++)
-			{
-				dvec4 plane0 = planes[i];
-				for (int j = 0; j < i; j++)
-				{
-					dvec4 plane1 = planes[j];
-
-					if ((plane0.x < 0.0 && plane1.x > 0.0) || (plane0.x > 0.0 && plane1.x < 0.0))
-					{
-						cursor.ClipBevel(plane0, plane1, dvec3(1.0, 0.0, 0.0));
-					}
-					if ((plane0.y < 0.0 && plane1.y > 0.0) || (plane0.y > 0.0 && plane1.y < 0.0))
-					{
-						cursor.ClipBevel(plane0, plane1, dvec3(0.0, 1.0, 0.0));
-					}
-					if ((plane0.z < 0.0 && plane1.z > 0.0) || (plane0.z > 0.0 && plane1.z < 0.0))
-					{
-						cursor.ClipBevel(plane0, plane1, dvec3(0.0, 0.0, 1.0));
-					}
-				}
-			}
-
 			// Did we hit anything?
 			double t = cursor.HitFraction();
 			if (t >= tmin && t < tmax)
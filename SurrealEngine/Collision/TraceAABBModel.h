@@ -66,35 +66,6 @@ private:
 			}
 		}
 
-		bool ClipBevel(const dvec4& plane0, const dvec4& plane1, const dvec3& bevelDirection)
-		{
-			dvec3 cross1 = cross(bevelDirection, plane0.xyz());
-			dvec3 cross2 = cross(bevelDirection, plane1.xyz());
-			if (dot(cross1, cross2) > 0.00001)
-			{
-				dvec3 linedir = cross(plane0.xyz(), plane1.xyz());
-				double length2 = dot(linedir, linedir);
-				if (length2 >= 0.000001)
-				{
-					dvec3 point = (plane0.w * cross(plane1.xyz(), linedir) + plane1.w * cross(linedir, plane0.xyz())) / length2;
-					linedir = normalize(linedir);
-
-					dvec3 normal = normalize(cross(bevelDirection, linedir));
-					if (dot(plane0.xyz(), normal) < 0.0)
-					{
-						normal = -normal;
-					}
-
-					dvec4 bevelplane(normal, dot(point, normal));
-					if (!ClipPlane(bevelplane))
-					{
-						return false;
-					}
-				}
-			}
-			return true;
-		}
-
 		bool ClipBoxPlanes(const BBox& box)
 		{ 
 			// Treat the sides of each AABB as a plane
@@ -32,33 +32,19 @@ CollisionHitList TraceCylinderLevel::Trace(ULevel* level, const vec3& from, cons
 		double dheight = height;
 		vec3 extents = { radius, radius, height };
 
-		ivec3 start = Level->Hash.GetSweepStartExtents(from, to, extents);
-		ivec3 end = Level->Hash.GetSweepEndExtents(from, to, extents);
-		if (end.x - start.x < 100 && end.y - start.y < 100 && end.z - start.z < 100)
-		{
-			for (int z = start.z; z < end.z; z++)
+		Level->Hash.ForEachSweepCell(from, to, extents, [&](const CollisionCell& cell)
 			{
-				for (int y = start.y; y < end.y; y++)
+				for (UActor* actor : cell)
 				{
-					for (int x = start.x; x < end.x; x++)
+					double t = actor->TraceTest(level, origin, tmin, direction, tmax, dheight, dradius);
+					if (t < tmax)
 					{
-						auto it = Level->Hash.CollisionActors.find(Level->Hash.GetBucketId(x, y, z));
-						if (it != Level->Hash.CollisionActors.end())
-						{
-							for (UActor* actor : it->second)
-							{
-								double t = actor->TraceTest(level, origin, tmin, direction, tmax, dheight, dradius);
-								if (t < tmax)
-								{
-									dvec3 hitpos = origin + direction * t;
-									hits.push_back({ (float)t, normalize(to_vec3(hitpos) - actor->Location()), actor, nullptr });
-								}
-							}
-						}
+						dvec3 hitpos = origin + direction * t;
+						hits.push_back({ (float)t, normalize(to_vec3(hitpos) - actor->Location()), actor, nullptr });
 					}
 				}
-			}
-		}
+				return true;
+			});
 	}
 
 	if (traceWorld)
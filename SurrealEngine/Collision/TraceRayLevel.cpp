@@ -22,32 +22,8 @@ bool TraceRayLevel::TraceAnyHit(ULevel* level, vec3 from, vec3 to, UActor* traci
 	float margin = 1.0f;
 	tmax += margin;
 
-	if (traceActors)
-	{
-		ivec3 start = Level->Hash.GetRayStartExtents(from, to);
-		ivec3 end = Level->Hash.GetRayEndExtents(from, to);
-		if (end.x - start.x < 100 && end.y - start.y < 100 && end.z - start.z < 100)
-		{
-			for (int z = start.z; z < end.z; z++)
-			{
-				for (int y = start.y; y < end.y; y++)
-				{
-					for (int x = start.x; x < end.x; x++)
-					{
-						auto it = Level->Hash.CollisionActors.find(Level->Hash.GetBucketId(x, y, z));
-						if (it != Level->Hash.CollisionActors.end())
-						{
-							for (UActor* actor : it->second)
-							{
-								if (actor != tracingActor && actor->bBlockActors() && Level->Hash.RayActorTrace(origin, tmin, direction, tmax, actor) < tmax)
-									return true;
-							}
-						}
-					}
-				}
-			}
-		}
-	}
+	if (traceActors && TraceActorsAnyHit(from, to, origin, tmin, direction, tmax, tracingActor))
+		return true;
 
 	if (traceWorld)
 	{
@@ -57,3 +33,89 @@ bool TraceRayLevel::TraceAnyHit(ULevel* level, vec3 from, vec3 to, UActor* traci
 
 	return false;
 }
+
+void TraceRayLevel::TraceAnyHit(ULevel* level, TraceRayQuery* rays, size_t count, bool traceActors, bool traceWorld, bool visibilityOnly)
+{
+	Level = level;
+
+	TraceRayModel tracemodel;
+	TraceRayPacket packet;
+	TraceRayQuery* packetRays[TraceRayPacket::Size];
+	int packetCount = 0;
+
+	auto flushPacket = [&]()
+		{
+			// Unused lanes repeat the last ray so that the lane loops never see garbage
+			for (int lane = packetCount; lane < TraceRayPacket::Size; lane++)
+			{
+				packet.OriginX[lane] = packet.OriginX[packetCount - 1];
+				packet.OriginY[lane] = packet.OriginY[packetCount - 1];
+				packet.OriginZ[lane] = packet.OriginZ[packetCount - 1];
+				packet.DirX[lane] = packet.DirX[packetCount - 1];
+				packet.DirY[lane] = packet.DirY[packetCount - 1];
+				packet.DirZ[lane] = packet.DirZ[packetCount - 1];
+				packet.TMin[lane] = packet.TMin[packetCount - 1];
+				packet.TMax[lane] = packet.TMax[packetCount - 1];
+			}
+
+			uint32_t hits = tracemodel.TraceAnyHit(Level->Model, packet, (1 << packetCount) - 1, visibilityOnly);
+			for (int lane = 0; lane < packetCount; lane++)
+				packetRays[lane]->Hit = (hits & (1 << lane)) != 0;
+			packetCount = 0;
+		};
+
+	for (size_t i = 0; i < count; i++)
+	{
+		TraceRayQuery& ray = rays[i];
+		ray.Hit = false;
+
+		if (ray.From == ray.To || (!traceActors && !traceWorld))
+			continue;
+
+		dvec3 origin = to_dvec3(ray.From);
+		dvec3 direction = to_dvec3(ray.To) - origin;
+		double tmin = 0.01f;
+		double tmax = length(direction);
+		if (tmax < tmin)
+			continue;
+		direction *= 1.0f / tmax;
+
+		float margin = 1.0f;
+		tmax += margin;
+
+		if (traceActors && TraceActorsAnyHit(ray.From, ray.To, origin, tmin, direction, tmax, ray.TracingActor))
+		{
+			ray.Hit = true;
+		}
+		else if (traceWorld)
+		{
+			packet.OriginX[packetCount] = origin.x;
+			packet.OriginY[packetCount] = origin.y;
+			packet.OriginZ[packetCount] = origin.z;
+			packet.DirX[packetCount] = direction.x;
+			packet.DirY[packetCount] = direction.y;
+			packet.DirZ[packetCount] = direction.z;
+			packet.TMin[packetCount] = tmin;
+			packet.TMax[packetCount] = tmax;
+			packetRays[packetCount++] = &ray;
+			if (packetCount == TraceRayPacket::Size)
+				flushPacket();
+		}
+	}
+
+	if (packetCount > 0)
+		flushPacket();
+}
+
+bool TraceRayLevel::TraceActorsAnyHit(const vec3& from, const vec3& to, const dvec3& origin, double tmin, const dvec3& direction, double tmax, UActor* tracingActor)
+{
+	return !Level->Hash.ForEachSweepCell(from, to, vec3(0.0f), [&](const CollisionCell& cell)
+		{
+			for (UActor* actor : cell)
+			{
+				if (actor != tracingActor && actor->bBlockActors() && Level->Hash.RayActorTrace(origin, tmin, direction, tmax, actor) < tmax)
+					return false;
+			}
+			return true;
+		});
+}
@@ -6,7 +6,10 @@ class TraceRayLevel
 {
 public:
 	bool TraceAnyHit(ULevel* level, vec3 from, vec3 to, UActor* tracingActor, bool traceActors, bool traceWorld, bool visibilityOnly);
+	void TraceAnyHit(ULevel* level, TraceRayQuery* rays, size_t count, bool traceActors, bool traceWorld, bool visibilityOnly);
 
 private:
+	bool TraceActorsAnyHit(const vec3& from, const vec3& to, const dvec3& origin, double tmin, const dvec3& direction, double tmax, UActor* tracingActor);
+
 	ULevel* Level = nullptr;
 };
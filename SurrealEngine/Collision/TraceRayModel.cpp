@@ -17,6 +17,12 @@ bool TraceRayModel::TraceAnyHit(UModel* model, const dvec3& origin, double tmin,
 	return TraceAnyHit(origin, tmin, dirNormalized, tmax, visibilityOnly, &Model->Nodes.front());
 }
 
+uint32_t TraceRayModel::TraceAnyHit(UModel* model, const TraceRayPacket& packet, uint32_t active, bool visibilityOnly)
+{
+	Model = model;
+	return TraceAnyHit(packet, active, visibilityOnly, &Model->Nodes.front());
+}
+
 void TraceRayModel::Trace(const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, bool visibilityOnly, BspNode* node, CollisionHitList& hits)
 {
 	BspNode* polynode = node;
@@ -76,6 +82,118 @@ bool TraceRayModel::TraceAnyHit(const dvec3& origin, double tmin, const dvec3& d
 		return false;
 }
 
+uint32_t TraceRayModel::TraceAnyHit(const TraceRayPacket& packet, uint32_t active, bool visibilityOnly, BspNode* node)
+{
+	const int size = TraceRayPacket::Size;
+
+	uint32_t hits = 0;
+	BspNode* polynode = node;
+	while (true)
+	{
+		if (!visibilityOnly || (polynode->NodeFlags & NF_NotVisBlocking) == 0)
+		{
+			hits |= NodeRayIntersect(packet, active & ~hits, polynode);
+			if ((active & ~hits) == 0)
+				return hits;
+		}
+
+		if (polynode->Plane < 0) break;
+		polynode = &Model->Nodes[polynode->Plane];
+	}
+
+	double fromSide[size], toSide[size];
+	for (int i = 0; i < size; i++)
+	{
+		fromSide[i] = packet.OriginX[i] * node->PlaneX + packet.OriginY[i] * node->PlaneY + packet.OriginZ[i] * node->PlaneZ - node->PlaneW;
+		toSide[i] = (packet.OriginX[i] + packet.DirX[i] * packet.TMax[i]) * node->PlaneX + (packet.OriginY[i] + packet.DirY[i] * packet.TMax[i]) * node->PlaneY + (packet.OriginZ[i] + packet.DirZ[i] * packet.TMax[i]) * node->PlaneZ - node->PlaneW;
+	}
+
+	uint32_t frontMask = 0, backMask = 0;
+	for (int i = 0; i < size; i++)
+	{
+		if (fromSide[i] >= 0.0 || toSide[i] >= 0.0)
+			frontMask |= 1 << i;
+		if (fromSide[i] <= 0.0 || toSide[i] <= 0.0)
+			backMask |= 1 << i;
+	}
+
+	uint32_t remaining = active & ~hits & frontMask;
+	if (node->Front >= 0 && remaining)
+		hits |= TraceAnyHit(packet, remaining, visibilityOnly, &Model->Nodes[node->Front]);
+
+	remaining = active & ~hits & backMask;
+	if (node->Back >= 0 && remaining)
+		hits |= TraceAnyHit(packet, remaining, visibilityOnly, &Model->Nodes[node->Back]);
+
+	return hits;
+}
+
+uint32_t TraceRayModel::NodeRayIntersect(const TraceRayPacket& packet, uint32_t active, BspNode* node)
+{
+	const int size = TraceRayPacket::Size;
+
+	if (active == 0 || node->NumVertices < 3 || (node->Surf >= 0 && Model->Surfaces[node->Surf].PolyFlags & PF_NotSolid))
+		return 0;
+
+	// Test if plane is actually crossed.
+	uint32_t crossing = 0;
+	for (int i = 0; i < size; i++)
+	{
+		double fromSide = packet.OriginX[i] * node->PlaneX + packet.OriginY[i] * node->PlaneY + packet.OriginZ[i] * node->PlaneZ - node->PlaneW;
+		double toSide = (packet.OriginX[i] + packet.DirX[i] * packet.TMax[i]) * node->PlaneX + (packet.OriginY[i] + packet.DirY[i] * packet.TMax[i]) * node->PlaneY + (packet.OriginZ[i] + packet.DirZ[i] * packet.TMax[i]) * node->PlaneZ - node->PlaneW;
+		if (!((fromSide > 0.0 && toSide > 0.0) || (fromSide < 0.0 && toSide < 0.0)))
+			crossing |= 1 << i;
+	}
+	active &= crossing;
+	if (active == 0)
+		return 0;
+
+	BspVert* v = &Model->Vertices[node->VertPool];
+	vec3* points = Model->Points.data();
+
+	dvec3 p0 = to_dvec3(points[v[0].Vertex]);
+	dvec3 p1 = to_dvec3(points[v[1].Vertex]);
+
+	uint32_t hits = 0;
+	int count = node->NumVertices;
+	for (int j = 2; j < count; j++)
+	{
+		dvec3 p2 = to_dvec3(points[v[j].Vertex]);
+
+		// Moeller-Trumbore for all rays against the same triangle (see TriangleRayIntersect)
+		dvec3 e1 = p1 - p0;
+		dvec3 e2 = p2 - p0;
+		for (int i = 0; i < size; i++)
+		{
+			double px = packet.DirY[i] * e2.z - packet.DirZ[i] * e2.y;
+			double py = packet.DirZ[i] * e2.x - packet.DirX[i] * e2.z;
+			double pz = packet.DirX[i] * e2.y - packet.DirY[i] * e2.x;
+			double det = e1.x * px + e1.y * py + e1.z * pz;
+			double inv_det = 1.0 / det;
+
+			double tx = packet.OriginX[i] - p0.x;
+			double ty = packet.OriginY[i] - p0.y;
+			double tz = packet.OriginZ[i] - p0.z;
+			double u = (tx * px + ty * py + tz * pz) * inv_det;
+
+			double qx = ty * e1.z - tz * e1.y;
+			double qy = tz * e1.x - tx * e1.z;
+			double qz = tx * e1.y - ty * e1.x;
+			double vv = (packet.DirX[i] * qx + packet.DirY[i] * qy + packet.DirZ[i] * qz) * inv_det;
+			double t = (e2.x * qx + e2.y * qy + e2.z * qz) * inv_det;
+
+			bool hit = !(det > -FLT_EPSILON && det < FLT_EPSILON) && u >= 0.0 && u <= 1.0 && vv >= 0.0 && u + vv <= 1.0 && t > FLT_EPSILON && t >= packet.TMin[i] && t < packet.TMax[i];
+			hits |= (uint32_t)hit << i;
+		}
+		hits &= active;
+		if (hits == active)
+			break;
+
+		p1 = p2;
+	}
+	return hits;
+}
+
 double TraceRayModel::NodeRayIntersect(const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, BspNode* node)
 {
 	if (node->NumVertices < 3 || (node->Surf >= 0 && Model->Surfaces[node->Surf].PolyFlags & PF_NotSolid))
@@ -2,15 +2,30 @@
 
 #include "UObject/ULevel.h"
 
+// Up to eight rays traced together through the BSP, stored as structure of arrays so the per-ray loops vectorize
+struct TraceRayPacket
+{
+	enum { Size = 8 };
+
+	double OriginX[Size], OriginY[Size], OriginZ[Size];
+	double DirX[Size], DirY[Size], DirZ[Size];
+	double TMin[Size], TMax[Size];
+};
+
 class TraceRayModel
 {
 public:
 	CollisionHitList Trace(UModel* model, const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, bool visibilityOnly);
 	bool TraceAnyHit(UModel* model, const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, bool visibilityOnly);
 
+	// Returns a bit mask of the rays in 'active' that hit something
+	uint32_t TraceAnyHit(UModel* model, const TraceRayPacket& packet, uint32_t active, bool visibilityOnly);
+
 private:
 	void Trace(const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, bool visibilityOnly, BspNode* node, CollisionHitList& hits);
 	bool TraceAnyHit(const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, bool visibilityOnly, BspNode* node);
+	uint32_t TraceAnyHit(const TraceRayPacket& packet, uint32_t active, bool visibilityOnly, BspNode* node);
+	uint32_t NodeRayIntersect(const TraceRayPacket& packet, uint32_t active, BspNode* node);
 
 	double NodeRayIntersect(const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, BspNode* node);
 	double TriangleRayIntersect(const dvec3& origin, const dvec3& dirNormalized, double tmax, const dvec3* points);
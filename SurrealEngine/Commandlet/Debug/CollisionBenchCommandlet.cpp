@@ -0,0 +1,132 @@
+
+#include "Precomp.h"
+#include "CollisionBenchCommandlet.h"
+#include "DebuggerApp.h"
+#include "Engine.h"
+#include "HeapAllocationCounter.h"
+#include "Collision/CollisionHash.h"
+#include "Package/PackageManager.h"
+#include "Package/TransientPackage.h"
+#include "UObject/UActor.h"
+#include <chrono>
+
+// Small deterministic generator, so every run moves the actors the same way
+static float NextRandom(uint32_t& seed)
+{
+	seed = seed * 1664525 + 1013904223;
+	return (seed >> 8) * (1.0f / 16777216.0f);
+}
+
+CollisionBenchCommandlet::CollisionBenchCommandlet()
+{
+	SetLongFormName("collisionbench");
+	SetShortDescription("Time inserts, moves and queries in the collision hash");
+}
+
+void CollisionBenchCommandlet::OnCommand(DebuggerApp* console, const std::string& args)
+{
+	if (!engine)
+	{
+		console->WriteOutput("Game must be running before the collision hash can be benchmarked" + NewLine());
+		return;
+	}
+
+	std::vector<std::string> params = SplitString(args);
+	if (params.size() > 2)
+	{
+		OnPrintHelp(console);
+		return;
+	}
+
+	int count = params.size() >= 1 ? std::stoi(params[0]) : 5000;
+	int frames = params.size() >= 2 ? std::stoi(params[1]) : 60;
+	if (count <= 0 || frames <= 0)
+		throw std::runtime_error("Invalid actor or frame count");
+
+	// The actors are not spawned into the level, so no script runs and the level's own hash is left alone
+	std::vector<UActor*> actors;
+	for (int i = 0; i < count; i++)
+		actors.push_back(UObject::Cast<UActor>(engine->packages->NewObject("collisionbench", "Engine", "Projectile")));
+
+	try
+	{
+		RunBenchmark(console, actors, frames);
+	}
+	catch (...)
+	{
+		engine->packages->GetTransientPackage()->ReleaseActors(actors);
+		throw;
+	}
+	engine->packages->GetTransientPackage()->ReleaseActors(actors);
+}
+
+void CollisionBenchCommandlet::RunBenchmark(DebuggerApp* console, const std::vector<UActor*>& actors, int frames)
+{
+	using namespace std::chrono;
+
+	// Same density for any actor count: about one actor per 64x64x64 units
+	float size = std::cbrt((float)actors.size()) * 64.0f;
+	uint32_t seed = 1;
+	for (UActor* actor : actors)
+	{
+		actor->Location() = vec3(NextRandom(seed), NextRandom(seed), NextRandom(seed)) * size;
+		actor->CollisionRadius() = 8.0f;
+		actor->CollisionHeight() = 8.0f;
+		actor->bCollideActors() = true;
+	}
+
+	CollisionHash hash;
+
+	uint64_t allocations = HeapAllocationCounter::GetCount();
+	auto start = steady_clock::now();
+	for (UActor* actor : actors)
+		hash.AddToCollision(actor);
+	PrintTiming(console, "Insert", duration<double>(steady_clock::now() - start).count(), HeapAllocationCounter::GetCount() - allocations, actors.size());
+
+	// Projectile-like movement of up to 40 units per frame
+	double moveSeconds = 0.0, querySeconds = 0.0;
+	uint64_t moveAllocations = 0, queryAllocations = 0;
+	size_t found = 0;
+	for (int frame = 0; frame < frames; frame++)
+	{
+		for (UActor* actor : actors)
+			actor->Location() += (vec3(NextRandom(seed), NextRandom(seed), NextRandom(seed)) * 2.0f - 1.0f) * 23.0f;
+
+		allocations = HeapAllocationCounter::GetCount();
+		start = steady_clock::now();
+		for (UActor* actor : actors)
+			hash.UpdateCollision(actor);
+		moveSeconds += duration<double>(steady_clock::now() - start).count();
+		moveAllocations += HeapAllocationCounter::GetCount() - allocations;
+
+		allocations = HeapAllocationCounter::GetCount();
+		start = steady_clock::now();
+		for (UActor* actor : actors)
+			found += hash.CollidingActors(actor->Location(), 8.0f, 8.0f).size();
+		querySeconds += duration<double>(steady_clock::now() - start).count();
+		queryAllocations += HeapAllocationCounter::GetCount() - allocations;
+	}
+
+	size_t total = actors.size() * frames;
+	PrintTiming(console, "Move", moveSeconds, moveAllocations, total);
+	PrintTiming(console, "Query", querySeconds, queryAllocations, total);
+	console->WriteOutput(std::to_string(hash.CollisionActors.Size()) + " cells, " + std::to_string((double)found / total) + " actors found per query" + NewLine());
+
+	for (UActor* actor : actors)
+		hash.RemoveFromCollision(actor);
+}
+
+void CollisionBenchCommandlet::PrintTiming(DebuggerApp* console, const std::string& name, double seconds, uint64_t allocations, size_t count)
+{
+	std::string line = name + ": " + std::to_string(seconds * 1000.0) + " ms total, " + std::to_string(seconds * 1'000'000'000.0 / count) + " ns per actor";
+	if (HeapAllocationCounter::IsEnabled())
+		line += ", " + std::to_string((double)allocations / count) + " allocations per actor";
+	console->WriteOutput(line + NewLine());
+}
+
+void CollisionBenchCommandlet::OnPrintHelp(DebuggerApp* console)
+{
+	console->WriteOutput("Syntax: collisionbench [actors] [frames]" + NewLine());
+	console->WriteOutput("Moves projectile sized actors through a standalone collision hash and queries around each of them every frame." + NewLine());
+	console->WriteOutput("The defaults are 5000 actors and 60 frames." + NewLine());
+}
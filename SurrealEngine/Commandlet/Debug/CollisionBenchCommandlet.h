@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Commandlet/Commandlet.h"
+
+class UActor;
+
+class CollisionBenchCommandlet : public Commandlet
+{
+public:
+	CollisionBenchCommandlet();
+
+	void OnCommand(DebuggerApp* console, const std::string& args) override;
+	void OnPrintHelp(DebuggerApp* console) override;
+
+private:
+	void RunBenchmark(DebuggerApp* console, const std::vector<UActor*>& actors, int frames);
+	void PrintTiming(DebuggerApp* console, const std::string& name, double seconds, uint64_t allocations, size_t count);
+};
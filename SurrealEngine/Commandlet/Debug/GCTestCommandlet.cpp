@@ -0,0 +1,158 @@
+
+#include "Precomp.h"
+#include "GCTestCommandlet.h"
+#include "DebuggerApp.h"
+#include "Engine.h"
+#include "GC/GC.h"
+#include "Package/PackageManager.h"
+#include "Package/Package.h"
+#include "Package/TransientPackage.h"
+#include "UObject/UClass.h"
+#include "UObject/UActor.h"
+#include "UObject/ULevel.h"
+#include "VM/Frame.h"
+#include <algorithm>
+
+static bool IsTransientObject(UObject* obj)
+{
+	for (auto& transientObj : engine->packages->GetTransientPackage()->GetObjects())
+	{
+		if (transientObj.get() == obj)
+			return true;
+	}
+	return false;
+}
+
+GCTestCommandlet::GCTestCommandlet()
+{
+	SetLongFormName("gctest");
+	SetShortDescription("Check that the garbage collector frees unreachable objects and keeps reachable ones");
+}
+
+void GCTestCommandlet::OnCommand(DebuggerApp* console, const std::string& args)
+{
+	if (!engine || !engine->Level || !engine->LevelPackage)
+	{
+		console->WriteOutput("A map must be loaded before the test can run" + NewLine());
+		return;
+	}
+
+	if (!Frame::Callstack.empty())
+	{
+		console->WriteOutput("The garbage collector can't run while script is running" + NewLine());
+		return;
+	}
+
+	TestCollect(console);
+	TestWriteBarrier(console);
+	TestUnloadMap(console);
+}
+
+void GCTestCommandlet::TestCollect(DebuggerApp* console)
+{
+	// Objects created while a mark is running are never collected by it
+	GC::Collect();
+
+	UClass* cls = UObject::Cast<UClass>(engine->packages->GetPackage("core")->GetUObject("Class", "Object"));
+	UObject* unreferenced = engine->packages->NewObject("gctest_unreferenced", cls);
+	GCRoot root;
+	root.set(engine->packages->NewObject("gctest_referenced", cls));
+	UObject* member = engine->packages->NewObject("gctest_member", cls);
+	root.get()->SetObject("Outer", member);
+
+	GC::Collect();
+
+	// Only pointers are compared, as the unreferenced object is gone
+	if (IsTransientObject(unreferenced))
+		console->WriteOutput("FAIL: an unreferenced transient object survived a collection" + NewLine());
+	else if (!IsTransientObject(root.get()) || !IsTransientObject(member))
+		console->WriteOutput("FAIL: a referenced transient object was collected" + NewLine());
+	else
+		console->WriteOutput("PASS: collect" + NewLine());
+}
+
+void GCTestCommandlet::TestWriteBarrier(DebuggerApp* console)
+{
+	GC::Collect();
+
+	UClass* cls = UObject::Cast<UClass>(engine->packages->GetPackage("core")->GetUObject("Class", "Object"));
+	GCRoot root;
+	root.set(engine->packages->NewObject("gctest_moved", cls));
+	UObject* moved = root.get();
+
+	// The level is scanned with the other package objects, before FinishMark. Moving the only reference into it after that
+	// leaves the object unreachable from anything still to be scanned.
+	UObject** outer = static_cast<UObject**>(engine->Level->GetProperty("Outer"));
+	UObject* oldOuter = *outer;
+	GC::StartMark();
+	GC::MarkStep(~(size_t)0);
+	engine->Level->SetObject("Outer", moved);
+	root.set(nullptr);
+	GC::FinishMark();
+	GC::Sweep(~(size_t)0);
+
+	bool survived = IsTransientObject(moved);
+	*outer = oldOuter;
+
+	if (survived)
+		console->WriteOutput("PASS: write barrier" + NewLine());
+	else
+		console->WriteOutput("FAIL: an object stored during marking was collected" + NewLine());
+}
+
+void GCTestCommandlet::TestUnloadMap(DebuggerApp* console)
+{
+	std::vector<UObject*> mapObjects;
+	for (auto& obj : engine->LevelPackage->GetObjects())
+	{
+		if (obj)
+			mapObjects.push_back(obj.get());
+	}
+	std::sort(mapObjects.begin(), mapObjects.end());
+
+	// Objects of the map's own classes that nothing but the transient package knows about
+	int created = 0;
+	for (UObject* obj : mapObjects)
+	{
+		UClass* cls = UObject::TryCast<UClass>(obj);
+		if (cls && (cls->ClsFlags & ClassFlags::Abstract) == 0)
+		{
+			engine->packages->NewObject("gctest", cls);
+			created++;
+		}
+	}
+
+	ULevel* level = engine->Level;
+	UnrealURL url = engine->LevelInfo->URL;
+	engine->UnloadMap();
+
+	// Only pointers are compared, as the objects are gone. Nothing may be allocated before this check.
+	int survivors = 0;
+	for (auto& obj : engine->packages->GetTransientPackage()->GetObjects())
+	{
+		UActor* actor = UObject::TryCast<UActor>(obj.get());
+		if ((actor && actor->XLevel() == level) || std::binary_search(mapObjects.begin(), mapObjects.end(), obj->Class))
+			survivors++;
+	}
+
+	GC::Collect();
+
+	engine->LoadMap(url);
+	engine->LoginPlayer();
+
+	if (created == 0)
+		console->WriteOutput("The map has no classes of its own. Only its actors were tested." + NewLine());
+
+	if (survivors == 0)
+		console->WriteOutput("PASS: unload map" + NewLine());
+	else
+		console->WriteOutput("FAIL: " + std::to_string(survivors) + " objects of the unloaded map survived" + NewLine());
+}
+
+void GCTestCommandlet::OnPrintHelp(DebuggerApp* console)
+{
+	console->WriteOutput("Syntax: gctest" + NewLine());
+	console->WriteOutput("Checks that a full collection frees an unreferenced transient object and keeps referenced ones," + NewLine());
+	console->WriteOutput("that an object stored into an already scanned object during an incremental mark survives," + NewLine());
+	console->WriteOutput("and that objects of the map's classes are gone after the map is reloaded." + NewLine());
+}
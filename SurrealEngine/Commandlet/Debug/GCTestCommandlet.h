@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Commandlet/Commandlet.h"
+
+class GCTestCommandlet : public Commandlet
+{
+public:
+	GCTestCommandlet();
+
+	void OnCommand(DebuggerApp* console, const std::string& args) override;
+	void OnPrintHelp(DebuggerApp* console) override;
+
+private:
+	void TestCollect(DebuggerApp* console);
+	void TestWriteBarrier(DebuggerApp* console);
+	void TestUnloadMap(DebuggerApp* console);
+};
@@ -0,0 +1,98 @@
+
+#include "Precomp.h"
+#include "ReleaseTestCommandlet.h"
+#include "DebuggerApp.h"
+#include "Engine.h"
+#include "Package/PackageManager.h"
+#include "UObject/UClass.h"
+#include "UObject/UActor.h"
+#include "UObject/ULevel.h"
+#include "VM/Frame.h"
+#include <algorithm>
+
+ReleaseTestCommandlet::ReleaseTestCommandlet()
+{
+	SetLongFormName("releasetest");
+	SetShortDescription("Move an actor after destroying it and check that releasing it leaves nothing behind");
+}
+
+void ReleaseTestCommandlet::OnCommand(DebuggerApp* console, const std::string& args)
+{
+	if (!engine || !engine->Level || !engine->LevelInfo)
+	{
+		console->WriteOutput("A map must be loaded before the test can run" + NewLine());
+		return;
+	}
+
+	if (!Frame::Callstack.empty())
+	{
+		console->WriteOutput("Actors can't be released while script is running" + NewLine());
+		return;
+	}
+
+	UClass* cls = engine->packages->FindClass("Engine.Trigger");
+	if (!cls)
+	{
+		console->WriteOutput("Engine.Trigger not found" + NewLine());
+		return;
+	}
+
+	ULevel* level = engine->Level;
+	UActor* owner = engine->LevelInfo;
+	vec3 location = owner->Location();
+	Rotator rotation = owner->Rotation();
+	UActor* actor = owner->Spawn(cls, nullptr, {}, &location, &rotation);
+	if (!actor)
+	{
+		console->WriteOutput("Could not spawn the test actor" + NewLine());
+		return;
+	}
+
+	std::vector<std::string> failures;
+	actor->SetCollision(true, false, false);
+	if (!actor->CollisionHashInfo.Inserted)
+		failures.push_back("the actor was not in the collision hash before it was destroyed");
+
+	actor->Destroy();
+
+	// The same calls script can make on the actor from its Destroyed event or later in the tick
+	actor->SetLocation(location + vec3(16.0f, 0.0f, 0.0f));
+	actor->SetCollision(true, true, true);
+	actor->SetCollisionSize(40.0f, 40.0f);
+	actor->Move(vec3(16.0f, 0.0f, 0.0f));
+	actor->SetOwner(owner);
+
+	if (actor->CollisionHashInfo.Inserted)
+		failures.push_back("the destroyed actor went back into the collision hash");
+	if (actor->BspInfo.Node)
+		failures.push_back("the destroyed actor went back into a bsp node");
+	if (actor->Owner())
+		failures.push_back("the destroyed actor got an owner");
+	if (std::find(owner->ChildActors.begin(), owner->ChildActors.end(), actor) != owner->ChildActors.end())
+		failures.push_back("the destroyed actor is in the child list of a live actor");
+
+	// The actor is freed here. Only its address is used afterwards.
+	level->ReleaseDestroyedActors();
+
+	for (UActor* other : level->Actors)
+	{
+		if (other && other->Owner() == actor)
+			failures.push_back("a live actor still has the released actor as owner");
+	}
+
+	if (failures.empty())
+	{
+		console->WriteOutput("PASS" + NewLine());
+	}
+	else
+	{
+		for (const std::string& failure : failures)
+			console->WriteOutput("FAIL: " + failure + NewLine());
+	}
+}
+
+void ReleaseTestCommandlet::OnPrintHelp(DebuggerApp* console)
+{
+	console->WriteOutput("Syntax: releasetest" + NewLine());
+	console->WriteOutput("Spawns a trigger, destroys it, moves it, and then releases the destroyed actors of the level." + NewLine());
+}
@@ -0,0 +1,111 @@
+
+#include "Precomp.h"
+#include "ScriptBenchCommandlet.h"
+#include "DebuggerApp.h"
+#include "Engine.h"
+#include "HeapAllocationCounter.h"
+#include "Package/PackageManager.h"
+#include "UObject/UClass.h"
+#include "VM/Frame.h"
+#include "VM/Bytecode.h"
+#include <chrono>
+
+ScriptBenchCommandlet::ScriptBenchCommandlet()
+{
+	SetLongFormName("scriptbench");
+	SetShortDescription("Time a script function with and without the bytecode optimizer");
+}
+
+void ScriptBenchCommandlet::RunBenchmark(DebuggerApp* console, const std::string& name, UFunction* func, UObject* instance, std::shared_ptr<Bytecode> code, int iterations)
+{
+	using namespace std::chrono;
+
+	func->Code = code;
+	Frame::Call(func, instance, {}); // Lowers the code before the timing starts
+
+	uint64_t allocations = HeapAllocationCounter::GetCount();
+	auto start = steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+		Frame::Call(func, instance, {});
+	double seconds = duration<double>(steady_clock::now() - start).count();
+	allocations = HeapAllocationCounter::GetCount() - allocations;
+
+	std::string line = name + ": " + std::to_string(code->Statements.size()) + " statements, ";
+	line += std::to_string(seconds * 1'000'000'000.0 / iterations) + " ns per call";
+	if (HeapAllocationCounter::IsEnabled())
+		line += ", " + std::to_string((double)allocations / iterations) + " allocations per call";
+	console->WriteOutput(line + NewLine());
+}
+
+void ScriptBenchCommandlet::OnCommand(DebuggerApp* console, const std::string& args)
+{
+	if (!engine)
+	{
+		console->WriteOutput("Game must be running before script can be benchmarked" + NewLine());
+		return;
+	}
+
+	std::vector<std::string> params = SplitString(args);
+	if (params.size() != 3 && params.size() != 4)
+	{
+		OnPrintHelp(console);
+		return;
+	}
+
+	int iterations = params.size() == 4 ? std::stoi(params[3]) : 100000;
+	if (iterations <= 0)
+		throw std::runtime_error("Invalid iteration count");
+
+	Package* package = engine->packages->GetPackage(params[0]);
+	UClass* cls = UObject::Cast<UClass>(package->GetUObject("Class", params[1]));
+	if (!cls)
+	{
+		console->WriteOutput("Class not found" + NewLine());
+		return;
+	}
+
+	UFunction* func = nullptr;
+	for (UField* child = cls->Children; child; child = child->Next)
+	{
+		if (child->Name == params[2] && dynamic_cast<UFunction*>(child))
+		{
+			func = static_cast<UFunction*>(child);
+			break;
+		}
+	}
+
+	if (!func || !func->Code || AllFlags(func->FuncFlags, FunctionFlags::Native))
+	{
+		console->WriteOutput("Script function not found" + NewLine());
+		return;
+	}
+
+	for (const FunctionParm& parm : func->Parms)
+	{
+		if (!parm.ReturnParm)
+		{
+			console->WriteOutput("Only functions without parameters can be benchmarked" + NewLine());
+			return;
+		}
+	}
+
+	UObject* instance = cls->GetDefaultObject();
+	std::shared_ptr<Bytecode> optimized = func->Code;
+	try
+	{
+		RunBenchmark(console, "Unoptimized", func, instance, std::make_shared<Bytecode>(func->Bytecode, package, false), iterations);
+		RunBenchmark(console, "Optimized", func, instance, optimized, iterations);
+	}
+	catch (...)
+	{
+		func->Code = optimized;
+		throw;
+	}
+	func->Code = optimized;
+}
+
+void ScriptBenchCommandlet::OnPrintHelp(DebuggerApp* console)
+{
+	console->WriteOutput("Syntax: scriptbench <package> <class> <function> [iterations]" + NewLine());
+	console->WriteOutput("The function is called on the class default object and must not take any parameters." + NewLine());
+}
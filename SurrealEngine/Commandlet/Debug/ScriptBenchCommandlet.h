@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Commandlet/Commandlet.h"
+
+class UFunction;
+class UObject;
+class Bytecode;
+
+class ScriptBenchCommandlet : public Commandlet
+{
+public:
+	ScriptBenchCommandlet();
+
+	void OnCommand(DebuggerApp* console, const std::string& args) override;
+	void OnPrintHelp(DebuggerApp* console) override;
+
+private:
+	void RunBenchmark(DebuggerApp* console, const std::string& name, UFunction* func, UObject* instance, std::shared_ptr<Bytecode> code, int iterations);
+};
@@ -11,6 +11,24 @@
 
 std::vector<NativeCppGenerator::NativeClass> NativeCppGenerator::classes;
 
+// FNV-1a, continued from the previous name
+static uint64_t HashLayoutName(uint64_t hash, const std::string& name)
+{
+	for (char c : name + "\n")
+	{
+		hash ^= (uint8_t)c;
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static std::string ToHexString(uint64_t value)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "0x%016llxULL", (unsigned long long)value);
+	return buffer;
+}
+
 void NativeCppGenerator::Run()
 {
 	classes.clear();
@@ -54,16 +72,23 @@ void NativeCppGenerator::Run()
 	packageManagerRegisterFuncsText += "\t// Copy/paste this into the PackageManager constructor\r\n";
 
 	propertyOffsetsHText += "#pragma once\r\n\r\n";
-	propertyOffsetsHText += "class PackageManager;\r\n\r\n";
-	propertyOffsetsHText += "void InitPropertyOffsets(PackageManager * packages); \r\n\r\n";
+	propertyOffsetsHText += "class PackageManager;\r\nclass CacheReader;\r\nclass CacheWriter;\r\n\r\n";
+	propertyOffsetsHText += "void InitPropertyOffsets(PackageManager * packages); \r\n";
+	propertyOffsetsHText += "void SavePropertyOffsets(CacheWriter& writer);\r\n";
+	propertyOffsetsHText += "bool LoadPropertyOffsets(CacheReader& reader);\r\n\r\n";
 	propertyOffsetsHText += "struct PropertyDataOffset\r\n{\r\n\tsize_t DataOffset = ~(size_t)0;\r\n\tuint32_t BitfieldMask = 1;\r\n};\r\n\r\n";
 
 	propertyOffsetsCppText += "#include \"Precomp.h\"\r\n";
 	propertyOffsetsCppText += "#include \"PropertyOffsets.h\"\r\n";
 	propertyOffsetsCppText += "#include \"Package/PackageManager.h\"\r\n";
+	propertyOffsetsCppText += "#include \"Package/PackageCache.h\"\r\n";
 	propertyOffsetsCppText += "#include \"UClass.h\"\r\n";
 	propertyOffsetsCppText += "#include \"UProperty.h\"\r\n\r\n";
 
+	std::string initPropertyOffsetsText;
+	std::string propertyOffsetsBlocksText;
+	uint64_t layoutHash = 14695981039346656037ULL;
+
 	for (auto cls : classes)
 	{
 		std::string nClassCppText;
@@ -128,17 +153,41 @@ void NativeCppGenerator::Run()
 		propertyOffsetsCppText += "\t\treturn;\r\n\t}\r\n";
 
 		propertyOffsetsHText += "struct " + propOffsetsStructName + "\r\n{\r\n";
+		initPropertyOffsetsText += "\tInitPropertyOffsets_" + cls.name + "(packages);\r\n";
+		propertyOffsetsBlocksText += "\t{ &" + propOffsetsVarName + ", sizeof(" + propOffsetsVarName + ") },\r\n";
+		layoutHash = HashLayoutName(layoutHash, cls.name);
 
 		for (auto prop : cls.props)
 		{
 			propertyOffsetsCppText += "\t" + propOffsetsVarName + "." + prop.name + " = cls->GetPropertyDataOffset(\"" + prop.name + "\");\r\n";
 			propertyOffsetsHText += "\tPropertyDataOffset " + prop.name + ";\r\n";
+			layoutHash = HashLayoutName(layoutHash, prop.name);
 		}
 
 		propertyOffsetsCppText += "}\r\n\r\n";
 		propertyOffsetsHText += "}\r\n\r\nextern " + propOffsetsVarDecl;
 	}
 
+	propertyOffsetsCppText += "void InitPropertyOffsets(PackageManager* packages)\r\n{\r\n" + initPropertyOffsetsText + "}\r\n\r\n";
+	propertyOffsetsCppText += "static const std::pair<void*, size_t> PropertyOffsetsBlocks[] =\r\n{\r\n" + propertyOffsetsBlocksText + "};\r\n\r\n";
+	propertyOffsetsCppText += "// Version of the data written by SavePropertyOffsets\r\n";
+	propertyOffsetsCppText += "static const uint32_t PropertyOffsetsFormatVersion = 1;\r\n\r\n";
+	propertyOffsetsCppText += "// FNV-1a hash of the class and property names in declaration order. Together with the struct sizes it identifies the layout.\r\n";
+	propertyOffsetsCppText += "static const uint64_t PropertyOffsetsLayoutHash = " + ToHexString(layoutHash) + ";\r\n\r\n";
+	propertyOffsetsCppText += "void SavePropertyOffsets(CacheWriter& writer)\r\n{\r\n";
+	propertyOffsetsCppText += "\twriter.WriteUInt32(PropertyOffsetsFormatVersion);\r\n";
+	propertyOffsetsCppText += "\twriter.WriteUInt64(PropertyOffsetsLayoutHash);\r\n";
+	propertyOffsetsCppText += "\twriter.WriteUInt32((uint32_t)(sizeof(PropertyOffsetsBlocks) / sizeof(PropertyOffsetsBlocks[0])));\r\n";
+	propertyOffsetsCppText += "\tfor (const auto& block : PropertyOffsetsBlocks)\r\n\t{\r\n";
+	propertyOffsetsCppText += "\t\twriter.WriteUInt64(block.second);\r\n";
+	propertyOffsetsCppText += "\t\twriter.WriteBytes(block.first, block.second);\r\n\t}\r\n}\r\n\r\n";
+	propertyOffsetsCppText += "bool LoadPropertyOffsets(CacheReader& reader)\r\n{\r\n";
+	propertyOffsetsCppText += "\tif (reader.ReadUInt32() != PropertyOffsetsFormatVersion || reader.ReadUInt64() != PropertyOffsetsLayoutHash || reader.ReadUInt32() != sizeof(PropertyOffsetsBlocks) / sizeof(PropertyOffsetsBlocks[0]))\r\n";
+	propertyOffsetsCppText += "\t\treturn false;\r\n\r\n";
+	propertyOffsetsCppText += "\tfor (const auto& block : PropertyOffsetsBlocks)\r\n\t{\r\n";
+	propertyOffsetsCppText += "\t\tif (reader.ReadUInt64() != block.second)\r\n\t\t\treturn false;\r\n";
+	propertyOffsetsCppText += "\t\treader.ReadBytes(block.first, block.second);\r\n\t}\r\n\treturn true;\r\n}\r\n";
+
 	File::write_all_text("Cpp/Package/PackageManager_RegisterFuncs.cpp", packageManagerRegisterFuncsText);
 	File::write_all_text("Cpp/UObject/PropertyOffsets.cpp", propertyOffsetsCppText);
 	File::write_all_text("Cpp/UObject/PropertyOffsets.h", propertyOffsetsHText);
@@ -127,6 +127,7 @@ void DeleteBreakpointCommandlet::OnCommand(DebuggerApp* console, const std::stri
 		if (index >= 0 && (size_t)index < Frame::Breakpoints.size())
 		{
 			Frame::Breakpoints.erase(Frame::Breakpoints.begin() + index);
+			Frame::UpdateBreakpoints();
 		}
 		else
 		{
@@ -151,6 +152,7 @@ ClearBreakpointsCommandlet::ClearBreakpointsCommandlet()
 void ClearBreakpointsCommandlet::OnCommand(DebuggerApp* console, const std::string& args)
 {
 	Frame::Breakpoints.clear();
+	Frame::UpdateBreakpoints();
 	console->WriteOutput("Removed all breakpoints" + NewLine());
 }
 
@@ -175,6 +177,7 @@ void EnableBreakpointCommandlet::OnCommand(DebuggerApp* console, const std::stri
 		if (index >= 0 && (size_t)index < Frame::Breakpoints.size())
 		{
 			Frame::Breakpoints[index].Enabled = true;
+			Frame::UpdateBreakpoints();
 			console->WriteOutput("Breakpoint #" + std::to_string(index) + " enabled" + NewLine());
 		}
 		else
@@ -205,6 +208,7 @@ void DisableBreakpointCommandlet::OnCommand(DebuggerApp* console, const std::str
 		if (index >= 0 && (size_t)index < Frame::Breakpoints.size())
 		{
 			Frame::Breakpoints[index].Enabled = false;
+			Frame::UpdateBreakpoints();
 			console->WriteOutput("Breakpoint #" + std::to_string(index) + " disabled" + NewLine());
 		}
 		else
@@ -30,7 +30,7 @@ void PrintCommandlet::OnCommand(DebuggerApp* console, const std::string& args)
 		{
 			if (prop->Name == chunks[0] && (UObject::TryCast<UObjectProperty>(prop) || UObject::TryCast<UClassProperty>(prop)))
 			{
-				void* ptr = ((uint8_t*)frame->Variables.get()) + prop->DataOffset.DataOffset;
+				void* ptr = ((uint8_t*)frame->Variables) + prop->DataOffset.DataOffset;
 				obj = *(UObject**)ptr;
 				bFoundObj = true;
 				break;
@@ -8,7 +8,11 @@
 #include "Commandlet/ExportCommandlet.h"
 #include "Commandlet/QuitCommandlet.h"
 #include "Commandlet/RunCommandlet.h"
+#include "Commandlet/Debug/CollisionBenchCommandlet.h"
 #include "Commandlet/Debug/CollisionCommandlet.h"
+#include "Commandlet/Debug/ScriptBenchCommandlet.h"
+#include "Commandlet/Debug/GCTestCommandlet.h"
+#include "Commandlet/Debug/ReleaseTestCommandlet.h"
 #include "Commandlet/VM/BreakpointCommandlet.h"
 #include "Commandlet/VM/CallstackCommandlet.h"
 #include "Commandlet/VM/DisassemblyCommandlet.h"
@@ -46,6 +50,7 @@ int DebuggerApp::Main(std::vector<std::string> args)
 	if (!launchinfo.gameRootFolder.empty())
 	{
 		Frame::RunDebugger = [=]() { FrameDebugBreak(); };
+		Frame::DebuggerAttached = true;
 
 		Engine engine(launchinfo);
 		engine.tickDebugger = [&]() { Tick(); };
@@ -88,6 +93,10 @@ void DebuggerApp::CreateCommandlets()
 	Commandlets.push_back(std::make_unique<ContinueCommandlet>());
 	Commandlets.push_back(std::make_unique<QuitCommandlet>());
 	Commandlets.push_back(std::make_unique<CollisionCommandlet>());
+	Commandlets.push_back(std::make_unique<CollisionBenchCommandlet>());
+	Commandlets.push_back(std::make_unique<ScriptBenchCommandlet>());
+	Commandlets.push_back(std::make_unique<GCTestCommandlet>());
+	Commandlets.push_back(std::make_unique<ReleaseTestCommandlet>());
 }
 
 void DebuggerApp::Tick()
@@ -2,6 +2,8 @@
 #include "Precomp.h"
 #include "Engine.h"
 #include "File.h"
+#include "HeapAllocationCounter.h"
+#include "GC/GC.h"
 #include "Render/RenderSubsystem.h"
 #include "Package/PackageManager.h"
 #include "Package/ObjectStream.h"
@@ -22,6 +24,7 @@
 #include "Audio/AudioSubsystem.h"
 #include "VM/Frame.h"
 #include "VM/ScriptCall.h"
+#include "VM/ScriptProfiler.h"
 #include <chrono>
 #include <set>
 
@@ -102,6 +105,8 @@ void Engine::Run()
 
 		UpdateInput(realTimeElapsed);
 
+		uint64_t heapAllocations = HeapAllocationCounter::GetCount();
+
 		CallEvent(console, EventName::Tick, { ExpressionValue::FloatValue(levelElapsed) });
 
 		// To do: set these to true if the frame rate is too low
@@ -115,6 +120,10 @@ void Engine::Run()
 			EntryLevel->Tick(entryLevelElapsed);
 		Level->Tick(levelElapsed);
 
+		TickHeapAllocations = HeapAllocationCounter::GetCount() - heapAllocations;
+
+		GC::Tick();
+
 		if (!LevelInfo->NextURL().empty())
 		{
 			LevelInfo->NextSwitchCountdown() -= levelElapsed;
@@ -267,6 +276,14 @@ void Engine::UnloadMap()
 
 	NameString packageName = LevelPackage->GetPackageName();
 
+	// Freed together with the level
+	if (CameraActor && CameraActor->XLevel() == Level)
+		CameraActor = nullptr;
+	GameInfo = nullptr;
+
+	GC::Cancel();
+	packages->GetTransientPackage()->ReleasePackage(LevelPackage, Level);
+
 	LevelInfo = nullptr;
 	Level = nullptr;
 	LevelPackage = nullptr;
@@ -287,7 +304,11 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 	UnloadMap();
 
 	// Load map objects
-	LevelPackage = packages->GetPackage(FilePath::remove_extension(url.Map));
+	NameString packageName = FilePath::remove_extension(url.Map);
+	PackagePreloadStats preload = packages->PreloadPackages(packageName);
+	double objectsStartTime = PackageManager::GetLoadTime();
+
+	LevelPackage = packages->GetPackage(packageName);
 
 	LevelInfo = UObject::Cast<ULevelInfo>(LevelPackage->GetUObject("LevelInfo", "LevelInfo0"));
 	if (packages->IsUnreal1())
@@ -316,12 +337,12 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 	Level->TravelInfo = travelInfo; // Initially used travel info for level restart
 
 	// Remove the actors meant for the editor (to do: should we do this at the package manager level?)
-	for (UActor*& actor : Level->Actors)
+	for (UActor* actor : Level->Actors)
 	{
 		if (actor && AllFlags(actor->Flags, ObjectFlags::NotForServer))
 		{
 			actor->bDeleteMe() = true;
-			actor = nullptr;
+			Level->RemoveActor(actor);
 		}
 	}
 
@@ -332,9 +353,16 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 		{
 			actor->XLevel() = Level;
 			Level->Hash.AddToCollision(actor);
+			if (actor->Owner())
+				actor->Owner()->AddChildActor(actor);
 		}
 	}
 
+	char timings[256];
+	snprintf(timings, sizeof(timings), "Map load: tables %.1f ms (%d packages), prefetch %.1f ms (%.1f MB), objects %.1f ms",
+		preload.tablesTime, (int)preload.numPackages, preload.prefetchTime, preload.prefetchBytes / (1024.0 * 1024.0), PackageManager::GetLoadTime() - objectsStartTime);
+	LogMessage(timings);
+
 	// Find the game info class
 	UClass* gameInfoClass = packages->FindClass(LevelInfo->URL.GetOption("game"));
 	if (!gameInfoClass)
@@ -355,7 +383,7 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 	GameInfo->bTicked() = false;
 	GameInfo->InitActorZone();
 
-	Level->Actors.push_back(GameInfo);
+	Level->AddActor(GameInfo);
 
 	// Note: this is never true. But maybe it will be once map loading or level hubs are implemented? If not, delete it!
 	if (LevelInfo->bBegunPlay())
@@ -385,7 +413,7 @@ void Engine::LoadMap(const UnrealURL& url, const std::map<std::string, std::stri
 			for (USpawnNotify* notifyObj = LevelInfo->SpawnNotify(); notifyObj != nullptr; notifyObj = notifyObj->Next())
 			{
 				UClass* cls = notifyObj->ActorClass();
-				if (cls && GameInfo->IsA(cls->Name))
+				if (cls && GameInfo->IsA(cls))
 					GameInfo = UObject::Cast<UGameInfo>(CallEvent(notifyObj, EventName::SpawnNotification, { ExpressionValue::ObjectValue(GameInfo) }).ToObject());
 			}
 		}
@@ -602,6 +630,44 @@ std::string Engine::ConsoleCommand(UObject* context, const std::string& commandl
 	{
 		render->ShowCollisionDebug = args[1] == "1";
 	}
+	else if (command == "scriptlowering" && args.size() == 2)
+	{
+		Frame::UseLoweredCode = args[1] == "1";
+	}
+	else if (command == "fixedphysics" && args.size() == 2)
+	{
+		LevelPhysics::FixedStep = args[1] == "1";
+	}
+	else if (command == "gc" && args.size() == 1)
+	{
+		GC::RequestCollect();
+	}
+	else if (command == "gcincremental" && args.size() == 2)
+	{
+		GC::Incremental = args[1] == "1";
+	}
+	else if (command == "scriptprofile" && args.size() >= 2)
+	{
+		if (args[1] == "start")
+		{
+			ScriptProfiler::Start();
+		}
+		else if (args[1] == "stop")
+		{
+			ScriptProfiler::Stop();
+		}
+		else if (args[1] == "report")
+		{
+			for (const std::string& line : ScriptProfiler::GetReport(args.size() == 3 ? std::atoi(args[2].c_str()) : 30))
+				LogMessage(line);
+		}
+		else if (args[1] == "dump")
+		{
+			std::string filename = args.size() == 3 ? args[2] : "scriptprofile.txt";
+			ScriptProfiler::SaveCollapsedStacks(filename);
+			LogMessage("Script profile saved to " + filename);
+		}
+	}
 	else if (command == "showlog")
 	{
 		//Frame::ShowDebuggerWindow();
@@ -172,6 +172,7 @@ public:
 	bool quit = false;
 
 	uint64_t lastTime = 0;
+	uint64_t TickHeapAllocations = 0; // Heap allocations made while ticking the levels in the last frame
 
 	void LoadEngineSettings();
 
@@ -11,6 +11,8 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <stdio.h>
 #include <unistd.h>
 #ifdef __APPLE__
@@ -117,6 +119,82 @@ std::shared_ptr<File> File::open_existing(const std::string &filename)
 	return std::make_shared<FileImpl>(handle);
 }
 
+class MappedFileImpl : public MappedFile
+{
+public:
+	MappedFileImpl(HANDLE mapping, const void* view, size_t size) : mapping(mapping), view(view)
+	{
+		ptr = static_cast<const uint8_t*>(view);
+		length = size;
+	}
+
+	~MappedFileImpl()
+	{
+		if (view)
+			UnmapViewOfFile(view);
+		if (mapping)
+			CloseHandle(mapping);
+	}
+
+	HANDLE mapping = nullptr;
+	const void* view = nullptr;
+};
+
+std::shared_ptr<MappedFile> MappedFile::open_existing(const std::string& filename)
+{
+	HANDLE handle = CreateFile(to_utf16(filename).c_str(), FILE_READ_ACCESS, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (handle == INVALID_HANDLE_VALUE)
+		throw std::runtime_error("Could not open " + filename);
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(handle, &fileSize) == FALSE)
+	{
+		CloseHandle(handle);
+		throw std::runtime_error("GetFileSizeEx failed");
+	}
+	if (fileSize.QuadPart == 0)
+	{
+		CloseHandle(handle);
+		return std::make_shared<MappedFileImpl>(nullptr, nullptr, 0);
+	}
+
+	// The view keeps the file open, so the handle itself isn't needed anymore
+	HANDLE mapping = CreateFileMapping(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(handle);
+	if (mapping == nullptr)
+		throw std::runtime_error("Could not map " + filename);
+
+	const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		CloseHandle(mapping);
+		throw std::runtime_error("Could not map " + filename);
+	}
+
+	return std::make_shared<MappedFileImpl>(mapping, view, (size_t)fileSize.QuadPart);
+}
+
+void MappedFile::prefetch(size_t offset, size_t count) const
+{
+	if (offset >= length)
+		return;
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = const_cast<uint8_t*>(ptr + offset);
+	range.NumberOfBytes = std::min(count, length - offset);
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+bool File::get_file_info(const std::string& filename, uint64_t& size, uint64_t& lastWriteTime)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data = {};
+	if (GetFileAttributesEx(to_utf16(filename).c_str(), GetFileExInfoStandard, &data) == FALSE)
+		return false;
+	size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+	lastWriteTime = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+	return true;
+}
+
 #else
 
 class FileImpl : public File
@@ -188,6 +266,73 @@ std::shared_ptr<File> File::open_existing(const std::string &filename)
 	return std::make_shared<FileImpl>(handle);
 }
 
+class MappedFileImpl : public MappedFile
+{
+public:
+	MappedFileImpl(void* view, size_t size) : view(view)
+	{
+		ptr = static_cast<const uint8_t*>(view);
+		length = size;
+	}
+
+	~MappedFileImpl()
+	{
+		if (view)
+			munmap(view, length);
+	}
+
+	void* view = nullptr;
+};
+
+std::shared_ptr<MappedFile> MappedFile::open_existing(const std::string& filename)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd == -1)
+		throw std::runtime_error("Could not open " + filename);
+
+	struct stat st = {};
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		throw std::runtime_error("fstat failed");
+	}
+	if (st.st_size == 0)
+	{
+		close(fd);
+		return std::make_shared<MappedFileImpl>(nullptr, 0);
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED)
+		throw std::runtime_error("Could not map " + filename);
+
+	return std::make_shared<MappedFileImpl>(view, (size_t)st.st_size);
+}
+
+void MappedFile::prefetch(size_t offset, size_t count) const
+{
+	if (offset >= length)
+		return;
+
+	// madvise wants a page aligned address. The mapping itself starts on a page boundary.
+	static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	size_t start = offset & ~(pageSize - 1);
+	size_t end = offset + std::min(count, length - offset);
+	madvise(const_cast<uint8_t*>(ptr + start), end - start, MADV_WILLNEED);
+}
+
+bool File::get_file_info(const std::string& filename, uint64_t& size, uint64_t& lastWriteTime)
+{
+	struct stat st = {};
+	if (stat(filename.c_str(), &st) != 0)
+		return false;
+	size = (uint64_t)st.st_size;
+	lastWriteTime = (uint64_t)st.st_mtime;
+	return true;
+}
+
 #endif
 
 void File::write_all_bytes(const std::string& filename, const void* data, size_t size)
@@ -35,6 +35,9 @@ public:
 	static std::string read_all_text(const std::string& filename);
 	static std::vector<std::string> read_all_lines(const std::string& filename);
 
+	// Size and modification time of a file. Returns false if the file doesn't exist.
+	static bool get_file_info(const std::string& filename, uint64_t& size, uint64_t& lastWriteTime);
+
 	uint8_t read_uint8() { uint8_t v; read(&v, sizeof(uint8_t)); return v; }
 	int8_t read_int8() { int8_t v; read(&v, sizeof(int8_t)); return v; }
 	uint16_t read_uint16() { uint16_t v; read(&v, sizeof(uint16_t)); return v; }
@@ -52,6 +55,24 @@ public:
 	virtual uint64_t tell() = 0;
 };
 
+// Read-only view of a whole file mapped into memory
+class MappedFile
+{
+public:
+	static std::shared_ptr<MappedFile> open_existing(const std::string& filename);
+
+	virtual ~MappedFile() = default;
+	const uint8_t* data() const { return ptr; }
+	size_t size() const { return length; }
+
+	// Asks the OS to start reading the range into memory in the background. Returns without waiting for the read.
+	void prefetch(size_t offset, size_t count) const;
+
+protected:
+	const uint8_t* ptr = nullptr;
+	size_t length = 0;
+};
+
 class Directory
 {
 public:
@@ -1,18 +1,43 @@
 
 #include "Precomp.h"
 #include "GC.h"
+#include "Engine.h"
+#include "Package/PackageManager.h"
+#include "Package/Package.h"
+#include "UObject/UClass.h"
+#include "UObject/UActor.h"
+#include "UObject/ULevel.h"
+#include "UObject/UClient.h"
+#include "UObject/USubsystem.h"
+#include "VM/Frame.h"
+#include <algorithm>
+
+bool GC::Incremental = false;
+size_t GC::MarkStepSize = 4096;
+size_t GC::SweepStepSize = 64;
+bool GC::Marking = false;
 
 static GCRoot* roots;
-static GCAllocation* allocations;
 static GCStats stats;
 
-#define GC_UNREFERENCED_FLAG ((size_t)1)
+static struct
+{
+	std::vector<UObject*> Candidates; // Sorted. Transient objects that are not actors.
+	std::vector<uint8_t> Marks;
+	std::vector<UObject*> MarkStack;
+	std::vector<UObject*> RootQueue; // Actors and package objects still to be scanned
+	size_t RootPos = 0;
+	std::vector<UObject*> Garbage; // Sorted
+	size_t SweepPos = 0;
+	size_t NextCollectCount = 1024;
+	bool Requested = false;
+} state;
 
 GCRoot::GCRoot()
 {
 	if (roots)
-		roots->next = this;
-	prev = roots;
+		roots->prev = this;
+	next = roots;
 	roots = this;
 }
 
@@ -33,106 +58,258 @@ GCRoot::~GCRoot()
 	}
 }
 
-void* GC::Alloc(GCType* type, size_t count)
+static void MarkObject(UObject* obj)
 {
-	size_t memsize = sizeof(GCAllocation) + type->size * count;
-	GCAllocation* allocation = (GCAllocation*)calloc(1, memsize);
-	if (allocation == nullptr)
-		throw std::bad_alloc();
-	allocation->allocklistNext = allocations;
-	allocation->type = type;
-	allocation->flags |= GC_UNREFERENCED_FLAG;
-	allocation->count = count;
-	allocations = allocation;
-	stats.numObjects++;
-	stats.memoryUsage += memsize;
-	return allocation + 1;
+	if (!obj || obj < state.Candidates.front() || obj > state.Candidates.back())
+		return;
+
+	auto it = std::lower_bound(state.Candidates.begin(), state.Candidates.end(), obj);
+	if (it != state.Candidates.end() && *it == obj)
+	{
+		uint8_t& mark = state.Marks[it - state.Candidates.begin()];
+		if (!mark)
+		{
+			mark = 1;
+			state.MarkStack.push_back(obj);
+		}
+	}
 }
 
-void GC::Collect()
+static void MarkReferences(void* data, const ObjectReferenceLayout& layout)
 {
-	GCAllocation* marklist = nullptr;
-	for (GCRoot* root = roots; root != nullptr; root = root->next)
-		marklist = MarkData(marklist, root->obj);
+	uint8_t* d = static_cast<uint8_t*>(data);
+	for (size_t offset : layout.Objects)
+		MarkObject(*reinterpret_cast<UObject**>(d + offset));
 
-	while (marklist)
+	for (auto& array : layout.Arrays)
 	{
-		marklist = Mark(marklist);
+		for (void* element : *reinterpret_cast<std::vector<void*>*>(d + array.first))
+			MarkReferences(element, *array.second);
 	}
+}
 
-	Sweep();
+static void MarkFrame(Frame* frame)
+{
+	MarkObject(frame->Object);
+	if (frame->Variables && frame->Func)
+		MarkReferences(frame->Variables, frame->Func->GetReferenceLayout());
 }
 
-GCStats GC::GetStats()
+static void ScanObject(UObject* obj)
 {
-	return stats;
+	if (!obj)
+		return;
+
+	MarkObject(obj);
+	if (obj->PropertyData.Data && obj->PropertyData.Class)
+		MarkReferences(obj->PropertyData.Data, obj->PropertyData.Class->GetReferenceLayout());
+	if (obj->StateFrame)
+		MarkFrame(obj->StateFrame.get());
+}
+
+void GC::Shade(UObject* value)
+{
+	MarkObject(value);
+}
+
+void GC::Shade(void* data, UStruct* s, size_t count)
+{
+	const ObjectReferenceLayout& layout = s->GetReferenceLayout();
+	if (layout.Objects.empty() && layout.Arrays.empty())
+		return;
+
+	uint8_t* d = static_cast<uint8_t*>(data);
+	for (size_t i = 0; i < count; i++)
+		MarkReferences(d + i * s->StructSize, layout);
+}
+
+void GC::Collect()
+{
+	if (!Marking)
+		StartMark();
+	MarkStep(~(size_t)0);
+	FinishMark();
+	Sweep(~(size_t)0);
 }
 
-GCAllocation* GC::MarkData(GCAllocation* marklist, void* data)
+void GC::Tick()
 {
-	if (data)
+	if (state.SweepPos < state.Garbage.size())
 	{
-		GCAllocation* allocation = ((GCAllocation*)data) - 1;
-		if (allocation->flags & GC_UNREFERENCED_FLAG)
-		{
-			allocation->flags &= ~GC_UNREFERENCED_FLAG;
-			allocation->marklistNext = marklist;
-			marklist = allocation;
-		}
+		Sweep(SweepStepSize);
+		return;
+	}
+
+	if (!Marking)
+	{
+		size_t objectCount = engine->packages->GetTransientPackage()->GetObjectCount();
+		if (!state.Requested && objectCount < state.NextCollectCount)
+			return;
+		StartMark();
 	}
-	return marklist;
+
+	bool all = state.Requested || !Incremental;
+	if (MarkStep(all ? ~(size_t)0 : MarkStepSize))
+	{
+		FinishMark();
+		Sweep(all ? ~(size_t)0 : SweepStepSize);
+		state.Requested = false;
+	}
+}
+
+void GC::RequestCollect()
+{
+	state.Requested = true;
 }
 
-GCAllocation* GC::Mark(GCAllocation* marklist)
+void GC::Cancel()
 {
-	GCAllocation* marklistout = nullptr;
-	for (GCAllocation* allocation = marklist; allocation != nullptr; allocation = allocation->marklistNext)
+	Marking = false;
+	state.Candidates.clear();
+	state.Marks.clear();
+	state.MarkStack.clear();
+	state.RootQueue.clear();
+	state.RootPos = 0;
+	state.Garbage.clear();
+	state.SweepPos = 0;
+}
+
+void GC::NoteReleased(const std::vector<UObject*>& objects)
+{
+	if (!Marking || objects.empty())
+		return;
+
+	// Released actors may still be waiting in the root queue. Candidates are never released outside the collector while marking.
+	auto end = std::remove_if(state.RootQueue.begin() + state.RootPos, state.RootQueue.end(),
+		[&](UObject* obj) { return std::binary_search(objects.begin(), objects.end(), obj); });
+	state.RootQueue.erase(end, state.RootQueue.end());
+}
+
+GCStats GC::GetStats()
+{
+	return stats;
+}
+
+void GC::StartMark()
+{
+	TransientPackage* transient = engine->packages->GetTransientPackage();
+
+	state.Candidates.clear();
+	state.Garbage.clear();
+	state.SweepPos = 0;
+	state.MarkStack.clear();
+	state.RootQueue.clear();
+	state.RootPos = 0;
+	stats.memoryUsage = 0;
+	for (auto& obj : transient->GetObjects())
 	{
-		GCType* type = allocation->type;
+		stats.memoryUsage += obj->PropertyData.Size;
+		if (UObject::TryCast<UActor>(obj.get()))
+			state.RootQueue.push_back(obj.get()); // Actors are only freed by Destroy or when their level is unloaded
+		else
+			state.Candidates.push_back(obj.get());
+	}
 
-		size_t size = type->size;
-		size_t count = allocation->count;
+	std::sort(state.Candidates.begin(), state.Candidates.end());
+	state.Marks.assign(state.Candidates.size(), 0);
 
-		for (const GCTypeMember& member : type->members)
+	// So is everything loaded from the packages: the map's own actors, the class default objects and objects such as textures
+	for (Package* package : engine->packages->GetLoadedPackages())
+	{
+		for (auto& obj : package->GetObjects())
 		{
-			uint8_t* d = (uint8_t*)(allocation + 1);
-			for (size_t i = 0; i < count; i++)
-			{
-				void* memberptr = *(void**)(d + member.offset);
-				marklistout = MarkData(marklistout, memberptr);
-				d += size;
-			}
+			if (obj)
+				state.RootQueue.push_back(obj.get());
 		}
 	}
-	return marklistout;
+
+	Marking = !state.Candidates.empty();
 }
 
-void GC::Sweep()
+bool GC::MarkStep(size_t maxObjects)
 {
-	GCAllocation* prev = nullptr;
-	GCAllocation* cur = allocations;
-	while (cur)
+	if (!Marking)
+		return true;
+
+	size_t count = 0;
+	while (count < maxObjects)
 	{
-		if (cur->flags & GC_UNREFERENCED_FLAG)
+		if (!state.MarkStack.empty())
+		{
+			UObject* obj = state.MarkStack.back();
+			state.MarkStack.pop_back();
+			ScanObject(obj);
+		}
+		else if (state.RootPos < state.RootQueue.size())
 		{
-			GCAllocation* unreferenced = cur;
-			unreferenced->flags &= ~GC_UNREFERENCED_FLAG;
-
-			cur = cur->allocklistNext;
-			if (prev)
-				prev->allocklistNext = cur;
-			else
-				allocations = cur;
-
-			stats.memoryUsage -= unreferenced->type->size * unreferenced->count;
-			stats.numObjects--;
-			free(unreferenced);
+			ScanObject(state.RootQueue[state.RootPos++]);
 		}
 		else
 		{
-			cur->flags |= GC_UNREFERENCED_FLAG;
-			prev = cur;
-			cur = cur->allocklistNext;
+			return true;
 		}
+		count++;
+	}
+	return false;
+}
+
+void GC::FinishMark()
+{
+	if (!Marking)
+		return;
+
+	// These roots are not objects the write barrier sees stores into, so they are scanned last, in one go. They are few.
+	UObject* globals[] =
+	{
+		engine->gameengine, engine->renderdev, engine->audiodev, engine->netdev, engine->client, engine->viewport, engine->canvas, engine->console,
+		engine->EntryLevelInfo, engine->EntryGameInfo, engine->LevelInfo, engine->GameInfo, engine->CameraActor
+	};
+	for (UObject* obj : globals)
+		ScanObject(obj);
+
+	for (GCRoot* root = roots; root != nullptr; root = root->next)
+		ScanObject(root->obj);
+
+	for (Frame* frame : Frame::Callstack)
+		MarkFrame(frame);
+
+	while (!state.MarkStack.empty())
+	{
+		UObject* obj = state.MarkStack.back();
+		state.MarkStack.pop_back();
+		ScanObject(obj);
+	}
+
+	for (size_t i = 0; i < state.Candidates.size(); i++)
+	{
+		if (!state.Marks[i])
+			state.Garbage.push_back(state.Candidates[i]);
+	}
+
+	state.RootQueue.clear();
+	state.RootPos = 0;
+	Marking = false;
+	stats.numCollections++;
+}
+
+void GC::Sweep(size_t maxObjects)
+{
+	// Unreachable objects can't become reachable again, so the sweep can be spread over several frames
+	size_t end = state.SweepPos + std::min(maxObjects, state.Garbage.size() - state.SweepPos);
+	if (state.SweepPos < end)
+	{
+		std::vector<UObject*> objects(state.Garbage.begin() + state.SweepPos, state.Garbage.begin() + end);
+		engine->packages->GetTransientPackage()->ReleaseObjects(objects);
+		stats.numFreed += objects.size();
+		state.SweepPos = end;
+	}
+
+	TransientPackage* transient = engine->packages->GetTransientPackage();
+	stats.numObjects = transient->GetObjectCount();
+	if (state.SweepPos == state.Garbage.size())
+	{
+		state.Garbage.clear();
+		state.SweepPos = 0;
+		state.NextCollectCount = std::max(stats.numObjects * 2, (size_t)1024);
 	}
 }
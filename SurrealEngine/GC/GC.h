@@ -1,48 +1,30 @@
 #pragma once
 
 #include <vector>
-#include <list>
 
-struct GCTypeMember
-{
-	size_t offset;
-};
-
-struct GCType
-{
-	size_t size;
-	std::vector<GCTypeMember> members;
-};
-
-struct GCAllocation
-{
-	union
-	{
-		GCType* type;
-		size_t flags;
-	};
-	size_t count;
-	GCAllocation* marklistNext;
-	GCAllocation* allocklistNext;
-};
+class UObject;
+class UStruct;
 
 struct GCStats
 {
-	size_t numObjects;
-	size_t memoryUsage;
+	size_t numObjects = 0; // Objects in the transient package
+	size_t memoryUsage = 0; // Property data used by the transient objects
+	size_t numCollections = 0;
+	size_t numFreed = 0;
 };
 
+// Keeps an object alive for as long as the root exists
 class GCRoot
 {
 public:
 	GCRoot();
 	~GCRoot();
 
-	void set(void* value) { obj = value; }
-	void* get() const { return obj; }
+	void set(UObject* value) { obj = value; }
+	UObject* get() const { return obj; }
 
 private:
-	void* obj = nullptr;
+	UObject* obj = nullptr;
 	GCRoot* prev = nullptr;
 	GCRoot* next = nullptr;
 
@@ -51,15 +33,41 @@ private:
 	friend class GC;
 };
 
+// Mark and sweep collector for the objects created at runtime.
+// The roots are the actors, the objects loaded from packages (including the class default objects), the script call stack,
+// the engine's own objects and any GCRoot. Everything that can't be reached from them is freed, except actors: their lifetime is
+// controlled by Destroy and by map unloads. Transient objects of a map's classes are freed by TransientPackage::ReleasePackage
+// before the map is unloaded, so the collector never sees an object whose class is gone.
+//
+// In incremental mode both marking and sweeping are spread over several frames. While marking, every object reference stored
+// by script, by a property copy or by UObject::SetObject goes through WriteBarrier, so an object that moves to an already scanned
+// object is still found. Objects created while marking are not collected in that cycle.
 class GC
 {
 public:
-	static void* Alloc(GCType* type, size_t count = 1);
-	static void Collect();
+	static void Collect(); // Full collection. Must not be called while script is running.
+	static void Tick(); // Called between frames. Starts a collection when the transient package has grown and advances incremental collections.
+	static void RequestCollect(); // Full collection at the next Tick
+	static void Cancel(); // Drops the pending mark and sweep. Used when a map is unloaded, as the classes of the garbage may go with it.
+	static void NoteReleased(const std::vector<UObject*>& objects); // Objects freed outside the collector. Must be sorted.
 	static GCStats GetStats();
 
+	static void WriteBarrier(UObject* value) { if (Marking && value) Shade(value); }
+	static void WriteBarrier(void* data, UStruct* s, size_t count) { if (Marking) Shade(data, s, count); } // Struct values copied to data
+
+	static bool Incremental; // Mark and sweep over several frames instead of all at once
+	static size_t MarkStepSize; // Objects scanned per frame in incremental mode
+	static size_t SweepStepSize; // Objects freed per frame in incremental mode
+
 private:
-	static GCAllocation* MarkData(GCAllocation* marklist, void* data);
-	static GCAllocation* Mark(GCAllocation* allocation);
-	static void Sweep();
+	static void StartMark();
+	static bool MarkStep(size_t maxObjects); // Returns true when only FinishMark is left
+	static void FinishMark();
+	static void Sweep(size_t maxObjects);
+	static void Shade(UObject* value);
+	static void Shade(void* data, UStruct* s, size_t count);
+
+	static bool Marking;
+
+	friend class GCTestCommandlet;
 };
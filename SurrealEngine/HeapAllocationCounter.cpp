@@ -0,0 +1,6 @@
+
+#include "Precomp.h"
+#include "HeapAllocationCounter.h"
+
+bool HeapAllocationCounter::Enabled = false;
+std::atomic<uint64_t> HeapAllocationCounter::Count;
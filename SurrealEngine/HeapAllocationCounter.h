@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <atomic>
+
+// Counts calls to the global operator new. Used to check that hot paths, such as script calls, don't allocate.
+// Only the debugger replaces operator new (HeapAllocationHooks.cpp). In the game and editor the counter is disabled and stays at zero.
+class HeapAllocationCounter
+{
+public:
+	static bool IsEnabled() { return Enabled; }
+	static uint64_t GetCount() { return Count.load(std::memory_order_relaxed); }
+
+private:
+	static bool Enabled;
+	static std::atomic<uint64_t> Count;
+	friend class HeapAllocationHooks;
+};
@@ -0,0 +1,55 @@
+
+#include "Precomp.h"
+#include "HeapAllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new with one that counts allocations.
+// This file is only part of the SurrealDebugger executable so that the game doesn't pay for the counting.
+
+class HeapAllocationHooks
+{
+public:
+	HeapAllocationHooks() { HeapAllocationCounter::Enabled = true; }
+
+	static void* Alloc(size_t size)
+	{
+		HeapAllocationCounter::Count.fetch_add(1, std::memory_order_relaxed);
+		void* data = std::malloc(size ? size : 1);
+		if (!data)
+			throw std::bad_alloc();
+		return data;
+	}
+};
+
+static HeapAllocationHooks hooks;
+
+void* operator new(size_t size)
+{
+	return HeapAllocationHooks::Alloc(size);
+}
+
+void* operator new[](size_t size)
+{
+	return HeapAllocationHooks::Alloc(size);
+}
+
+void operator delete(void* data) noexcept
+{
+	std::free(data);
+}
+
+void operator delete[](void* data) noexcept
+{
+	std::free(data);
+}
+
+void operator delete(void* data, size_t size) noexcept
+{
+	std::free(data);
+}
+
+void operator delete[](void* data, size_t size) noexcept
+{
+	std::free(data);
+}
@@ -0,0 +1,120 @@
+
+#include "Precomp.h"
+#include "JobSystem.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class JobSystemWorkers
+{
+public:
+	JobSystemWorkers()
+	{
+		int count = (int)std::thread::hardware_concurrency() - 1;
+		for (int i = 0; i < count; i++)
+			Threads.push_back(std::thread([this]() { WorkerMain(); }));
+	}
+
+	~JobSystemWorkers()
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		StopFlag = true;
+		lock.unlock();
+		WorkCondition.notify_all();
+		for (std::thread& thread : Threads)
+			thread.join();
+	}
+
+	void Run(size_t count, size_t batchSize, const std::function<void(size_t, size_t)>& func)
+	{
+		std::unique_lock<std::mutex> lock(Mutex);
+		Func = &func;
+		Count = count;
+		BatchSize = batchSize;
+		NextIndex = 0;
+		ActiveWorkers = (int)Threads.size();
+		Generation++;
+		lock.unlock();
+		WorkCondition.notify_all();
+
+		RunBatches();
+
+		lock.lock();
+		DoneCondition.wait(lock, [&]() { return ActiveWorkers == 0; });
+		Func = nullptr;
+	}
+
+	std::vector<std::thread> Threads;
+
+private:
+	void WorkerMain()
+	{
+		uint64_t lastGeneration = 0;
+		std::unique_lock<std::mutex> lock(Mutex);
+		while (true)
+		{
+			WorkCondition.wait(lock, [&]() { return StopFlag || Generation != lastGeneration; });
+			if (StopFlag)
+				break;
+			lastGeneration = Generation;
+
+			lock.unlock();
+			RunBatches();
+			lock.lock();
+
+			ActiveWorkers--;
+			if (ActiveWorkers == 0)
+				DoneCondition.notify_all();
+		}
+	}
+
+	void RunBatches()
+	{
+		while (true)
+		{
+			size_t start = NextIndex.fetch_add(BatchSize);
+			if (start >= Count)
+				break;
+			(*Func)(start, std::min(start + BatchSize, Count));
+		}
+	}
+
+	std::mutex Mutex;
+	std::condition_variable WorkCondition;
+	std::condition_variable DoneCondition;
+	const std::function<void(size_t, size_t)>* Func = nullptr;
+	size_t Count = 0;
+	size_t BatchSize = 1;
+	std::atomic<size_t> NextIndex = 0;
+	int ActiveWorkers = 0;
+	uint64_t Generation = 0;
+	bool StopFlag = false;
+};
+
+static JobSystemWorkers& GetWorkers()
+{
+	static JobSystemWorkers workers;
+	return workers;
+}
+
+void JobSystem::ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t start, size_t end)>& func)
+{
+	if (count == 0)
+		return;
+
+	batchSize = std::max(batchSize, (size_t)1);
+	JobSystemWorkers& workers = GetWorkers();
+	if (workers.Threads.empty() || count <= batchSize)
+	{
+		func(0, count);
+		return;
+	}
+
+	workers.Run(count, batchSize, func);
+}
+
+int JobSystem::GetWorkerCount()
+{
+	return (int)GetWorkers().Threads.size();
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <functional>
+
+// Small pool of worker threads for data parallel loops.
+// ParallelFor is meant to be called from the main thread only and must not be nested.
+class JobSystem
+{
+public:
+	// Calls func(start, end) for batches of [0, count). The calling thread helps out and the call returns when all batches are done.
+	static void ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t start, size_t end)>& func);
+
+	static int GetWorkerCount();
+};
@@ -1,7 +1,191 @@
 
 #include "Precomp.h"
 #include "NameString.h"
+#include <mutex>
+#include <shared_mutex>
 
-std::vector<std::string> NameString::Names;
-std::unordered_map<std::string, int> NameString::CompareStringToIndex;
-std::unordered_map<std::string, std::pair<int, int>> NameString::SpellStringToIndex;
+std::atomic<std::string*> NameString::Chunks[NameString::MaxChunks];
+
+// Table key. The hash is calculated once and kept, so the maps never hash a string again when they grow.
+struct NameKey
+{
+	std::string_view Value;
+	size_t Hash;
+
+	bool operator==(const NameKey& other) const { return Hash == other.Hash && Value == other.Value; }
+};
+
+struct NameKeyHash
+{
+	size_t operator()(const NameKey& key) const { return key.Hash; }
+};
+
+class NameTable
+{
+public:
+	static NameTable& Get()
+	{
+		static NameTable table;
+		return table;
+	}
+
+	void Find(std::string_view value, int& compareIndex, int& spelledIndex);
+
+private:
+	NameTable();
+
+	static size_t HashString(std::string_view value);
+	int Add(std::string_view value);
+
+	enum { ShardCount = 16 };
+
+	// Names are spread over several maps with their own lock so that threads rarely wait on each other.
+	// Lookups of names already in the table only take a shared lock.
+	template<typename T>
+	struct Shard
+	{
+		std::shared_mutex Mutex;
+		std::unordered_map<NameKey, T, NameKeyHash> Map;
+	};
+
+	Shard<std::pair<int, int>> SpellShards[ShardCount];
+	Shard<int> CompareShards[ShardCount];
+
+	std::atomic<int> NextIndex = 0;
+	std::mutex ChunkMutex;
+};
+
+NameTable::NameTable()
+{
+	// None is always index 0
+	int index = Add("None");
+	size_t spellHash = HashString("None");
+	size_t compareHash = HashString("NONE");
+	SpellShards[spellHash % ShardCount].Map[{ NameString::GetString(index), spellHash }] = { index, index };
+	CompareShards[compareHash % ShardCount].Map[{ "NONE", compareHash }] = index;
+}
+
+void NameTable::Find(std::string_view value, int& compareIndex, int& spelledIndex)
+{
+	// Have we seen this spelling before?
+	size_t spellHash = HashString(value);
+	auto& spellShard = SpellShards[spellHash % ShardCount];
+	{
+		std::shared_lock lock(spellShard.Mutex);
+		auto it = spellShard.Map.find({ value, spellHash });
+		if (it != spellShard.Map.end())
+		{
+			compareIndex = it->second.first;
+			spelledIndex = it->second.second;
+			return;
+		}
+	}
+
+	// Any empty name string means None
+	if (value.empty())
+	{
+		compareIndex = 0;
+		spelledIndex = 0;
+		return;
+	}
+
+	// Create case insensitive spelling string
+	static const int stricmptable[] =
+	{
+		0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+		0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+		0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f,
+		0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f,
+		0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+		0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x5b, 0x5c, 0x5d, 0x5e, 0x5f,
+		0x60, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c, 0x4d, 0x4e, 0x4f,
+		0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5a, 0x7b, 0x7c, 0x7d, 0x7e, 0x7f,
+		0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8e, 0x8f,
+		0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f,
+		0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xab, 0xac, 0xad, 0xae, 0xaf,
+		0xb0, 0xb1, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xbb, 0xbc, 0xbd, 0xbe, 0xbf,
+		0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xcb, 0xcc, 0xcd, 0xce, 0xcf,
+		0xd0, 0xd1, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xdb, 0xdc, 0xdd, 0xde, 0xdf,
+		0xe0, 0xe1, 0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xeb, 0xec, 0xed, 0xee, 0xef,
+		0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0xff
+	};
+
+	std::string compareValue(value);
+	for (size_t i = 0, count = compareValue.size(); i < count; i++)
+	{
+		compareValue[i] = (char)stricmptable[(uint8_t)compareValue[i]];
+	}
+
+	// Do we have a compare index?
+	size_t compareHash = HashString(compareValue);
+	auto& compareShard = CompareShards[compareHash % ShardCount];
+	{
+		std::unique_lock lock(compareShard.Mutex);
+		auto it = compareShard.Map.find({ compareValue, compareHash });
+		if (it != compareShard.Map.end())
+		{
+			compareIndex = it->second;
+		}
+		else
+		{
+			compareIndex = Add(compareValue);
+			compareShard.Map[{ NameString::GetString(compareIndex), compareHash }] = compareIndex;
+		}
+	}
+
+	// Create spellstring index, unless another thread added it while the lock was released
+	std::unique_lock lock(spellShard.Mutex);
+	auto it = spellShard.Map.find({ value, spellHash });
+	if (it != spellShard.Map.end())
+	{
+		compareIndex = it->second.first;
+		spelledIndex = it->second.second;
+		return;
+	}
+
+	spelledIndex = Add(value);
+	spellShard.Map[{ NameString::GetString(spelledIndex), spellHash }] = { compareIndex, spelledIndex };
+}
+
+int NameTable::Add(std::string_view value)
+{
+	int index = NextIndex++;
+	int chunkIndex = index >> NameString::ChunkShift;
+	if (chunkIndex >= NameString::MaxChunks)
+		throw std::runtime_error("Too many names");
+
+	std::string* chunk = NameString::Chunks[chunkIndex].load(std::memory_order_acquire);
+	if (!chunk)
+	{
+		std::unique_lock lock(ChunkMutex);
+		chunk = NameString::Chunks[chunkIndex].load(std::memory_order_acquire);
+		if (!chunk)
+		{
+			chunk = new std::string[NameString::ChunkSize];
+			NameString::Chunks[chunkIndex].store(chunk, std::memory_order_release);
+		}
+	}
+
+	// The slot only becomes visible to other threads once its index is published through a shard map
+	chunk[index & (NameString::ChunkSize - 1)] = value;
+	return index;
+}
+
+size_t NameTable::HashString(std::string_view value)
+{
+	// FNV-1a
+	uint64_t hash = 14695981039346656037ULL;
+	for (char c : value)
+	{
+		hash ^= (uint8_t)c;
+		hash *= 1099511628211ULL;
+	}
+	return (size_t)hash;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NameString::GetIndex(std::string_view value)
+{
+	NameTable::Get().Find(value, CompareIndex, SpelledIndex);
+}
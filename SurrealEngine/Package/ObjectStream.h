@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Package.h"
+#include "File.h"
 #include <string.h>
 #include <stdexcept>
 
@@ -11,7 +12,12 @@ class UObject;
 class ObjectStream
 {
 public:
-	ObjectStream(Package* package, std::unique_ptr<uint64_t[]> buf, size_t startoffset, size_t size, ObjectFlags flags, const NameString& name, UClass* base) : package(package), buffer(std::move(buf)), data(reinterpret_cast<const uint8_t*>(buffer.get())), startoffset(startoffset), size(size), flags(flags), name(name), base(base) { }
+	// Reads the object directly from the mapped package file
+	ObjectStream(Package* package, std::shared_ptr<MappedFile> file, size_t startoffset, size_t size, ObjectFlags flags, const NameString& name, UClass* base) : package(package), file(std::move(file)), startoffset(startoffset), size(size), flags(flags), name(name), base(base)
+	{
+		if (this->file)
+			data = this->file->data() + startoffset;
+	}
 
 	void ReadBytes(void* d, uint32_t s)
 	{
@@ -164,7 +170,7 @@ public:
 
 private:
 	Package* package = nullptr;
-	std::unique_ptr<uint64_t[]> buffer;
+	std::shared_ptr<MappedFile> file;
 	const uint8_t* data = nullptr;
 	size_t startoffset = 0;
 	size_t size = 0;
@@ -209,9 +209,7 @@ UObject* Package::NewObject(const NameString& objname, UClass* objclass, ObjectF
 			if (initProperties)
 			{
 				obj->PropertyData.Init(objclass);
-				obj->SetObject("Class", obj->Class);
-				obj->SetName("Name", obj->Name);
-				obj->SetInt("ObjectFlags", (int)obj->Flags);
+				obj->SyncNativeProperties();
 			}
 			return obj;
 		}
@@ -273,6 +271,11 @@ UObject* Package::GetUObject(int objref)
 	else if (objref < 0) // Import table object
 	{
 		ImportTableEntry* entry = GetImportEntry(objref);
+
+		int importIndex = -objref - 1;
+		if (ImportResolved[importIndex])
+			return ImportObjects[importIndex];
+
 		ImportTableEntry* entrypackage = GetImportEntry(entry->ObjPackage);
 
 		NameString groupName;
@@ -295,6 +298,8 @@ UObject* Package::GetUObject(int objref)
 		else if (!obj && packageName == "UnrealShare")
 			obj = Packages->GetPackage("UnrealI")->GetUObject(className, objectName, groupName);
 
+		ImportObjects[importIndex] = obj;
+		ImportResolved[importIndex] = true;
 		return obj;
 	}
 	else
@@ -310,14 +315,15 @@ UObject* Package::GetUObject(const NameString& className, const NameString& obje
 
 int Package::FindObjectReference(const NameString& className, const NameString& objectName, const NameString& groupName)
 {
+	auto it = ExportNameIndex.find(objectName.GetCompareIndex());
+	if (it == ExportNameIndex.end())
+		return 0;
+
 	bool isClass = className == "Class";
 
-	size_t count = ExportTable.size();
-	for (size_t index = 0; index < count; index++)
+	for (int index : it->second)
 	{
 		ExportTableEntry& entry = ExportTable[index];
-		if (GetName(entry.ObjName) != objectName)
-			continue;
 
 		if (!groupName.IsNone())
 		{
@@ -353,7 +359,7 @@ int Package::FindObjectReference(const NameString& className, const NameString&
 			}
 			else
 			{
-				auto classExport = &ExportTable[entry.ObjClass + 1];
+				auto classExport = GetExportEntry(entry.ObjClass);
 				if (classExport && className == GetName(classExport->ObjName))
 					return (int)index + 1;
 			}
@@ -474,6 +480,7 @@ void Package::ReadTables()
 		entry.ObjSize = stream->ReadIndex();
 		entry.ObjOffset = (entry.ObjSize > 0) ? stream->ReadIndex() : -1;
 		ExportTable.push_back(entry);
+		ExportNameIndex[GetName(entry.ObjName).GetCompareIndex()].push_back((int)i);
 	}
 
 	stream->Seek(importOffset);
@@ -486,6 +493,14 @@ void Package::ReadTables()
 		entry.ObjName = stream->ReadIndex();
 		ImportTable.push_back(entry);
 	}
+
+	ClearImportCache();
+}
+
+void Package::ClearImportCache()
+{
+	ImportObjects.assign(ImportTable.size(), nullptr);
+	ImportResolved.assign(ImportTable.size(), false);
 }
 
 std::unique_ptr<ObjectStream> Package::OpenObjectStream(int index, const NameString& name, UClass* base)
@@ -493,14 +508,13 @@ std::unique_ptr<ObjectStream> Package::OpenObjectStream(int index, const NameStr
 	const auto& entry = ExportTable[index];
 	if (entry.ObjSize > 0)
 	{
-		std::unique_ptr<uint64_t[]> buffer(new uint64_t[(entry.ObjSize + 7) / 8]);
-		auto stream = Packages->GetStream(this);
-		stream->Seek(entry.ObjOffset);
-		stream->ReadBytes(buffer.get(), entry.ObjSize);
-		return std::make_unique<ObjectStream>(this, std::move(buffer), entry.ObjOffset, entry.ObjSize, entry.ObjFlags, name, base);
+		std::shared_ptr<MappedFile> file = Packages->GetMappedFile(this);
+		if (entry.ObjOffset < 0 || (size_t)entry.ObjOffset + (size_t)entry.ObjSize > file->size())
+			throw std::runtime_error("Export table entry out of bounds in " + Name.ToString());
+		return std::make_unique<ObjectStream>(this, std::move(file), entry.ObjOffset, entry.ObjSize, entry.ObjFlags, name, base);
 	}
 	else
 	{
-		return std::make_unique<ObjectStream>(this, std::unique_ptr<uint64_t[]>(), 0, 0, entry.ObjFlags, name, base);
+		return std::make_unique<ObjectStream>(this, std::shared_ptr<MappedFile>(), 0, 0, entry.ObjFlags, name, base);
 	}
 }
@@ -63,6 +63,12 @@ public:
 
 	std::vector<UClass*> GetAllClasses();
 
+	// Objects loaded from the package so far, by export table index. Objects that haven't been loaded are null.
+	const std::vector<std::unique_ptr<UObject>>& GetObjects() const { return Objects; }
+
+	// Forgets the resolved imports. Needed when a package they may point into is unloaded.
+	void ClearImportCache();
+
 private:
 	void ReadTables();
 	std::unique_ptr<ObjectStream> OpenObjectStream(int index, const NameString& name, UClass* base);
@@ -90,6 +96,8 @@ private:
 					NameHash[className] = (int)NameTable.size() - 1;
 				}
 
+				ExportNameIndex[className.GetCompareIndex()].push_back((int)ExportTable.size());
+
 				ExportTableEntry entry;
 				entry.ObjClass = 0;
 				entry.ObjBase = baseClass.IsNone() ? 0 : FindObjectReference("Class", baseClass);
@@ -115,6 +123,13 @@ private:
 
 	std::map<NameString, int> NameHash;
 
+	// Export table indices with a given object name (keyed by its compare index), in table order
+	std::unordered_map<int, std::vector<int>> ExportNameIndex;
+
+	// Objects the import table entries resolved to
+	std::vector<UObject*> ImportObjects;
+	std::vector<bool> ImportResolved;
+
 	std::vector<std::unique_ptr<UObject>> Objects;
 
 	std::map<NameString, std::function<UObject*(const NameString& name, UClass* cls, ObjectFlags flags)>> NativeClasses;
@@ -0,0 +1,152 @@
+
+#include "Precomp.h"
+#include "PackageCache.h"
+#include "File.h"
+#include <string.h>
+
+static const uint32_t CacheSignature = 0x48434553; // "SECH"
+static const uint32_t CacheVersion = 1;
+
+std::string CacheReader::ReadString()
+{
+	uint32_t length = ReadUInt32();
+	std::string s;
+	s.resize(length);
+	ReadBytes(s.data(), length);
+	return s;
+}
+
+void CacheReader::ReadBytes(void* d, size_t s)
+{
+	const uint8_t* src = ReadData(s);
+	if (s > 0)
+		memcpy(d, src, s);
+}
+
+const uint8_t* CacheReader::ReadData(size_t s)
+{
+	if (s > size - pos)
+		throw std::runtime_error("Unexpected end of cache data");
+	const uint8_t* src = data + pos;
+	pos += s;
+	return src;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+PackageCache::PackageCache(const std::string& filename) : Filename(filename)
+{
+	Load();
+}
+
+PackageCache::~PackageCache()
+{
+}
+
+void PackageCache::Load()
+{
+	try
+	{
+		Mapping = MappedFile::open_existing(Filename);
+	}
+	catch (...)
+	{
+		return;
+	}
+
+	try
+	{
+		CacheReader reader(Mapping->data(), Mapping->size());
+		if (reader.ReadUInt32() != CacheSignature || reader.ReadUInt32() != CacheVersion)
+			return;
+
+		uint32_t count = reader.ReadUInt32();
+		for (uint32_t i = 0; i < count; i++)
+		{
+			std::string key = reader.ReadString();
+			Entry entry;
+			entry.Stamp = reader.ReadString();
+			entry.Size = (size_t)reader.ReadUInt64();
+			entry.Data = reader.ReadData(entry.Size); // Used in place from the mapped file
+			Entries[key] = std::move(entry);
+		}
+	}
+	catch (...)
+	{
+		// A damaged cache is treated as empty
+		Entries.clear();
+	}
+}
+
+bool PackageCache::Find(const std::string& key, const std::string& stamp, CacheReader& reader)
+{
+	auto it = Entries.find(key);
+	if (it == Entries.end() || it->second.Stamp != stamp)
+		return false;
+
+	reader = CacheReader(it->second.Data, it->second.Size);
+	return true;
+}
+
+void PackageCache::Store(const std::string& key, const std::string& stamp, std::vector<uint8_t> data)
+{
+	Entry& entry = Entries[key];
+	entry.Stamp = stamp;
+	entry.Buffer = std::move(data);
+	entry.Data = entry.Buffer.data();
+	entry.Size = entry.Buffer.size();
+	Dirty = true;
+}
+
+void PackageCache::Save()
+{
+	if (!Dirty)
+		return;
+
+	CacheWriter writer;
+	writer.WriteUInt32(CacheSignature);
+	writer.WriteUInt32(CacheVersion);
+	writer.WriteUInt32((uint32_t)Entries.size());
+	for (auto& it : Entries)
+	{
+		writer.WriteString(it.first);
+		writer.WriteString(it.second.Stamp);
+		writer.WriteUInt64(it.second.Size);
+		writer.WriteBytes(it.second.Data, it.second.Size);
+	}
+
+	// The file can't be replaced while it is mapped
+	for (auto& it : Entries)
+	{
+		if (it.second.Buffer.empty() && it.second.Size > 0)
+		{
+			it.second.Buffer.assign(it.second.Data, it.second.Data + it.second.Size);
+			it.second.Data = it.second.Buffer.data();
+		}
+	}
+	Mapping.reset();
+
+	try
+	{
+		File::write_all_bytes(Filename, writer.Data.data(), writer.Data.size());
+		Dirty = false;
+	}
+	catch (...)
+	{
+		// The game folder may be read only. The cache is then rebuilt on every start.
+	}
+}
+
+std::string PackageCache::GetFileStamp(const std::vector<std::string>& filenames)
+{
+	std::string stamp;
+	for (const std::string& filename : filenames)
+	{
+		uint64_t size = 0, lastWriteTime = 0;
+		if (File::get_file_info(filename, size, lastWriteTime))
+			stamp += filename + ":" + std::to_string(size) + ":" + std::to_string(lastWriteTime) + ";";
+		else
+			stamp += filename + ":missing;";
+	}
+	return stamp;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+class MappedFile;
+
+class CacheWriter
+{
+public:
+	void WriteUInt32(uint32_t value) { WriteBytes(&value, sizeof(value)); }
+	void WriteUInt64(uint64_t value) { WriteBytes(&value, sizeof(value)); }
+	void WriteString(const std::string& value) { WriteUInt32((uint32_t)value.size()); WriteBytes(value.data(), value.size()); }
+	void WriteBytes(const void* data, size_t size) { Data.insert(Data.end(), static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + size); }
+
+	std::vector<uint8_t> Data;
+};
+
+class CacheReader
+{
+public:
+	CacheReader() = default;
+	CacheReader(const uint8_t* data, size_t size) : data(data), size(size) { }
+
+	uint32_t ReadUInt32() { uint32_t v; ReadBytes(&v, sizeof(v)); return v; }
+	uint64_t ReadUInt64() { uint64_t v; ReadBytes(&v, sizeof(v)); return v; }
+	std::string ReadString();
+	void ReadBytes(void* d, size_t s);
+	const uint8_t* ReadData(size_t s); // Returns the next s bytes without copying them
+
+	bool IsEnd() const { return pos == size; }
+
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	size_t pos = 0;
+};
+
+// Data derived from the game files that is slow to build, kept on disk between runs.
+// Every entry has a stamp describing the files it was built from and is only used while the stamp still matches.
+class PackageCache
+{
+public:
+	PackageCache(const std::string& filename);
+	~PackageCache();
+
+	bool Find(const std::string& key, const std::string& stamp, CacheReader& reader);
+	void Store(const std::string& key, const std::string& stamp, std::vector<uint8_t> data);
+
+	// Writes the cache file if any entry changed
+	void Save();
+
+	// Names, sizes and modification times of the files
+	static std::string GetFileStamp(const std::vector<std::string>& filenames);
+
+private:
+	struct Entry
+	{
+		std::string Stamp;
+		const uint8_t* Data = nullptr;
+		size_t Size = 0;
+		std::vector<uint8_t> Buffer; // Set for entries not read from the file
+	};
+
+	void Load();
+
+	std::string Filename;
+	std::shared_ptr<MappedFile> Mapping;
+	std::map<std::string, Entry> Entries;
+	bool Dirty = false;
+
+	PackageCache(const PackageCache&) = delete;
+	PackageCache& operator=(const PackageCache&) = delete;
+};
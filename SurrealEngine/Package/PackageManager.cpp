@@ -3,11 +3,15 @@
 #include "PackageManager.h"
 #include "Package.h"
 #include "PackageStream.h"
+#include "PackageCache.h"
 #include "IniFile.h"
 #include "File.h"
 #include "UObject/UObject.h"
 #include "UObject/UClass.h"
 #include "VM/NativeFunc.h"
+#include "VM/Frame.h"
+#include "VM/ScriptProfiler.h"
+#include "JobSystem.h"
 #include "Native/NActor.h"
 #include "Native/NCanvas.h"
 #include "Native/NCommandlet.h"
@@ -36,22 +40,33 @@
 #include "Native/NParticleIterator.h"
 #include "Native/NScriptedPawn.h"
 #include "Native/NPlayerPawnExt.h"
+#include <atomic>
+#include <chrono>
+#include <algorithm>
 
 PackageManager::PackageManager(const GameLaunchInfo& launchInfo) : launchInfo(launchInfo)
 {
+	transientPackage = std::make_unique<TransientPackage>(this);
 	RegisterFunctions();
 	LoadEngineIniFiles();
+	cache = std::make_unique<PackageCache>(FilePath::combine(launchInfo.gameRootFolder, "System/SE-" + launchInfo.gameExecutableName + ".cache"));
 	LoadIntFiles();
 	LoadPackageRemaps();
 	ScanPaths();
 	ScanForMaps();
 
-	InitPropertyOffsets(this);
+	LoadPropertyOffsets();
+	InitEngineClasses(this);
+	cache->Save();
 
 	// File::write_all_text("C:\\Development\\UTNativeProps.txt", NativeObjExtractor::Run(this));
 	// File::write_all_text("C:\\Development\\UTNativeFuncs.txt", NativeFuncExtractor::Run(this));
 }
 
+PackageManager::~PackageManager()
+{
+}
+
 Package* PackageManager::GetPackage(const NameString& name)
 {
 	auto& package = packages[name];
@@ -76,18 +91,30 @@ void PackageManager::UnloadPackage(const NameString& name)
 	auto it = packages.find(name);
 	if (it != packages.end())
 	{
-		for (auto streamit = openStreams.begin(); streamit != openStreams.end(); ++streamit)
+		Frame::RemovePackageBreakpoints(name);
+		ScriptProfiler::ForgetFunctions();
+		mappedFiles.erase(it->second->GetPackageName());
+		packages.erase(it);
+
+		for (auto& package : packages)
 		{
-			if (streamit->Pkg == it->second.get())
-			{
-				openStreams.erase(streamit);
-				break;
-			}
+			if (package.second)
+				package.second->ClearImportCache();
 		}
-		packages.erase(it);
 	}
 }
 
+std::vector<Package*> PackageManager::GetLoadedPackages()
+{
+	std::vector<Package*> result;
+	for (auto& it : packages)
+	{
+		if (it.second)
+			result.push_back(it.second.get());
+	}
+	return result;
+}
+
 void PackageManager::ScanForMaps()
 {
 	for (auto& mapFolderPath : mapFolders)
@@ -167,31 +194,159 @@ std::vector<NameString> PackageManager::GetPackageNames() const
 
 std::shared_ptr<PackageStream> PackageManager::GetStream(Package* package)
 {
-	int numStreams = 0;
-	for (auto it = openStreams.begin(); it != openStreams.end(); ++it)
+	return std::make_shared<PackageStream>(package, GetMappedFile(package));
+}
+
+std::shared_ptr<MappedFile> PackageManager::GetMappedFile(Package* package)
+{
+	std::shared_ptr<MappedFile>& file = mappedFiles[package->GetPackageName()];
+	if (!file)
+		file = MappedFile::open_existing(package->GetPackageFilename());
+	return file;
+}
+
+double PackageManager::GetLoadTime()
+{
+	using namespace std::chrono;
+	return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count() / 1000.0;
+}
+
+// Upper bounds for the table entries, as the exact sizes aren't known until the tables are parsed.
+// A compact index takes at most 5 bytes and a name at most 64 characters.
+static const size_t PackageHeaderSize = 36;
+static const uint64_t MaxNameEntrySize = 5 + 64 + 4; // Name, flags
+static const uint64_t MaxExportEntrySize = 5 + 5 + 4 + 5 + 4 + 5 + 5; // Class, super, package, name, flags, size, offset
+static const uint64_t MaxImportEntrySize = 5 + 5 + 4 + 5; // Class package, class name, package, name
+
+// Starts reading the name, export and import tables
+static void PrefetchTables(const MappedFile& file)
+{
+	if (file.size() < PackageHeaderSize)
+		return;
+
+	uint32_t header[PackageHeaderSize / 4];
+	memcpy(header, file.data(), sizeof(header));
+	uint32_t nameCount = header[3], nameOffset = header[4];
+	uint32_t exportCount = header[5], exportOffset = header[6];
+	uint32_t importCount = header[7], importOffset = header[8];
+
+	file.prefetch(nameOffset, (size_t)std::min(nameCount * MaxNameEntrySize, (uint64_t)file.size()));
+	file.prefetch(exportOffset, (size_t)std::min(exportCount * MaxExportEntrySize, (uint64_t)file.size()));
+	file.prefetch(importOffset, (size_t)std::min(importCount * MaxImportEntrySize, (uint64_t)file.size()));
+}
+
+static bool IsHeavyClass(const NameString& className)
+{
+	static const NameString heavyClasses[] = { "Texture", "Sound", "Music", "Mesh", "LodMesh", "SkeletalMesh" };
+	for (const NameString& name : heavyClasses)
+	{
+		if (className == name)
+			return true;
+	}
+	return false;
+}
+
+static const ImportTableEntry* GetImportPackageEntry(Package* package, const ImportTableEntry* entry)
+{
+	while (entry->ObjPackage != 0)
+		entry = package->GetImportEntry(entry->ObjPackage);
+	return entry;
+}
+
+PackagePreloadStats PackageManager::PreloadPackages(const NameString& name)
+{
+	PackagePreloadStats stats;
+
+	// Tables phase: open the map and the packages it imports objects from. What those packages import in turn is left to the normal load.
+	double startTime = GetLoadTime();
+	auto itMap = packages.find(name);
+	if (itMap == packages.end() || !itMap->second)
+		stats.numPackages++;
+	Package* map = GetPackage(name);
+
+	std::vector<NameString> names;
+	std::vector<std::string> filenames;
+	for (const ImportTableEntry& entry : map->ImportTable)
 	{
-		if ((*it).Pkg == package)
+		if (entry.ObjPackage == 0)
+			continue;
+
+		NameString packageName = map->GetName(GetImportPackageEntry(map, &entry)->ObjName);
+		auto it = packages.find(packageName);
+		if ((it != packages.end() && it->second) || std::find(names.begin(), names.end(), packageName) != names.end())
+			continue;
+
+		auto itFilename = packageFilenames.find(packageName);
+		if (itFilename != packageFilenames.end())
 		{
-			if (it != openStreams.begin())
+			names.push_back(packageName);
+			filenames.push_back(itFilename->second);
+		}
+	}
+
+	std::vector<std::shared_ptr<MappedFile>> files(names.size());
+	JobSystem::ParallelFor(names.size(), 1, [&](size_t start, size_t end)
+		{
+			for (size_t i = start; i < end; i++)
 			{
-				OpenStream s = *it;
-				openStreams.erase(it);
-				openStreams.push_front(s);
+				try
+				{
+					files[i] = MappedFile::open_existing(filenames[i]);
+					PrefetchTables(*files[i]);
+				}
+				catch (...)
+				{
+					// GetPackage reports the error when the import is resolved
+				}
 			}
-			return openStreams.front().Stream;
-		}
-		numStreams++;
+		});
+
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		if (!files[i])
+			continue;
+
+		mappedFiles[names[i]] = files[i];
+		GetPackage(names[i]);
+		stats.numPackages++;
 	}
+	stats.tablesTime = GetLoadTime() - startTime;
 
-	OpenStream s;
-	s.Pkg = package;
-	s.Stream = std::make_shared<PackageStream>(package, File::open_existing(package->GetPackageFilename()));
-	openStreams.push_front(s);
+	// Prefetch phase: have the OS read the map itself and the textures, sounds and meshes it imports in the background
+	startTime = GetLoadTime();
+	std::shared_ptr<MappedFile> file = GetMappedFile(map);
+	file->prefetch(0, file->size());
+	stats.prefetchBytes += file->size();
 
-	if (numStreams == 10)
-		openStreams.pop_back();
+	for (const ImportTableEntry& entry : map->ImportTable)
+	{
+		if (entry.ObjPackage == 0 || !IsHeavyClass(map->GetName(entry.ClassName)))
+			continue;
 
-	return openStreams.front().Stream;
+		auto it = packages.find(map->GetName(GetImportPackageEntry(map, &entry)->ObjName));
+		if (it == packages.end() || !it->second)
+			continue;
+
+		Package* source = it->second.get();
+		auto itExports = source->ExportNameIndex.find(map->GetName(entry.ObjName).GetCompareIndex());
+		if (itExports == source->ExportNameIndex.end())
+			continue;
+
+		std::shared_ptr<MappedFile> sourceFile = GetMappedFile(source);
+		for (int index : itExports->second)
+		{
+			const ExportTableEntry& exportEntry = source->ExportTable[index];
+			if (exportEntry.ObjSize > 0 && exportEntry.ObjOffset >= 0 && (size_t)exportEntry.ObjOffset + exportEntry.ObjSize <= sourceFile->size())
+			{
+				sourceFile->prefetch((size_t)exportEntry.ObjOffset, (size_t)exportEntry.ObjSize);
+				stats.prefetchBytes += exportEntry.ObjSize;
+			}
+		}
+	}
+
+	stats.prefetchTime = GetLoadTime() - startTime;
+
+	return stats;
 }
 
 void PackageManager::DelayLoadNow()
@@ -212,13 +367,12 @@ UObject* PackageManager::NewObject(const NameString& name, const NameString& pac
 	UClass* cls = UObject::Cast<UClass>(pkg->GetUObject("Class", className));
 	if (!cls)
 		throw std::runtime_error("Could not find class " + className.ToString());
-	return pkg->NewObject(name, cls, ObjectFlags::NoFlags, true);
+	return transientPackage->NewObject(name, cls, ObjectFlags::NoFlags);
 }
 
 UObject* PackageManager::NewObject(const NameString& name, UClass* cls)
 {
-	// To do: package needs to be grabbed from outer, or the "transient package" if it is None, a virtual package for runtime objects
-	return GetPackage("Engine")->NewObject(name, cls, ObjectFlags::NoFlags, true);
+	return transientPackage->NewObject(name, cls, ObjectFlags::NoFlags);
 }
 
 UClass* PackageManager::FindClass(const NameString& name)
@@ -349,10 +503,70 @@ void PackageManager::LoadEngineIniFiles()
 	}
 }
 
+static void WriteIntObjects(CacheWriter& writer, const std::map<NameString, std::vector<IntObject>>& intObjects)
+{
+	writer.WriteUInt32((uint32_t)intObjects.size());
+	for (auto& it : intObjects)
+	{
+		writer.WriteString(it.first.ToString());
+		writer.WriteUInt32((uint32_t)it.second.size());
+		for (const IntObject& obj : it.second)
+		{
+			writer.WriteString(obj.Name.ToString());
+			writer.WriteString(obj.Class.ToString());
+			writer.WriteString(obj.MetaClass.ToString());
+			writer.WriteString(obj.Description);
+		}
+	}
+}
+
+static std::map<NameString, std::vector<IntObject>> ReadIntObjects(CacheReader& reader)
+{
+	std::map<NameString, std::vector<IntObject>> intObjects;
+	uint32_t count = reader.ReadUInt32();
+	for (uint32_t i = 0; i < count; i++)
+	{
+		std::vector<IntObject>& objects = intObjects[NameString(reader.ReadString())];
+		objects.resize(reader.ReadUInt32());
+		for (IntObject& obj : objects)
+		{
+			obj.Name = reader.ReadString();
+			obj.Class = reader.ReadString();
+			obj.MetaClass = reader.ReadString();
+			obj.Description = reader.ReadString();
+		}
+	}
+	return intObjects;
+}
+
 void PackageManager::LoadIntFiles()
 {
 	std::string systemdir = FilePath::combine(launchInfo.gameRootFolder, "System");
-	for (std::string filename : Directory::files(FilePath::combine(systemdir, "*.int")))
+	std::vector<std::string> filenames = Directory::files(FilePath::combine(systemdir, "*.int"));
+	std::vector<std::string> paths;
+	for (const std::string& filename : filenames)
+	{
+		intFilenames[FilePath::remove_extension(filename)] = FilePath::combine(systemdir, filename);
+		paths.push_back(FilePath::combine(systemdir, filename));
+	}
+
+	// Only the object lists are needed at startup. Localize opens the .int files themselves when it needs them.
+	std::string stamp = PackageCache::GetFileStamp(paths);
+	CacheReader reader;
+	if (cache->Find("IntObjects", stamp, reader))
+	{
+		try
+		{
+			IntObjects = ReadIntObjects(reader);
+			return;
+		}
+		catch (...)
+		{
+			IntObjects.clear();
+		}
+	}
+
+	for (const std::string& filename : filenames)
 	{
 		try
 		{
@@ -400,6 +614,43 @@ void PackageManager::LoadIntFiles()
 		{
 		}
 	}
+
+	CacheWriter writer;
+	WriteIntObjects(writer, IntObjects);
+	cache->Store("IntObjects", stamp, std::move(writer.Data));
+}
+
+void PackageManager::LoadPropertyOffsets()
+{
+	// The offsets depend on the classes in these packages and on how this build lays out property data
+	std::vector<std::string> filenames;
+	for (const char* name : { "core", "engine", "fire", "ipdrv" })
+	{
+		auto it = packageFilenames.find(name);
+		if (it != packageFilenames.end())
+			filenames.push_back(it->second);
+	}
+	std::string stamp = std::to_string(launchInfo.engineVersion) + "." + std::to_string(launchInfo.engineSubVersion) + ";" + UStruct::GetPropertyLayoutStamp() + ";" + PackageCache::GetFileStamp(filenames);
+
+	// A cache hit also means the classes don't have to be loaded at startup
+	CacheReader reader;
+	if (cache->Find("PropertyOffsets", stamp, reader))
+	{
+		try
+		{
+			if (::LoadPropertyOffsets(reader))
+				return;
+		}
+		catch (...)
+		{
+		}
+	}
+
+	InitPropertyOffsets(this);
+
+	CacheWriter writer;
+	SavePropertyOffsets(writer);
+	cache->Store("PropertyOffsets", stamp, std::move(writer.Data));
 }
 
 std::vector<IntObject>& PackageManager::GetIntObjects(const NameString& metaclass)
@@ -425,7 +676,11 @@ std::string PackageManager::Localize(NameString packageName, const NameString& s
 	{
 		try
 		{
-			intFile = std::make_unique<IniFile>(FilePath::combine(launchInfo.gameRootFolder, "System/" + packageName.ToString() + ".int"));
+			auto it = intFilenames.find(packageName);
+			if (it != intFilenames.end())
+				intFile = std::make_unique<IniFile>(it->second);
+			else
+				intFile = std::make_unique<IniFile>(FilePath::combine(launchInfo.gameRootFolder, "System/" + packageName.ToString() + ".int"));
 		}
 		catch (...)
 		{
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "Package.h"
+#include "TransientPackage.h"
 #include "IniFile.h"
 #include "GameFolder.h"
-#include <list>
 
 class PackageStream;
+class MappedFile;
+class PackageCache;
+class CacheReader;
+class CacheWriter;
 class UObject;
 class UClass;
 
@@ -17,10 +21,19 @@ struct IntObject
 	std::string Description;
 };
 
+struct PackagePreloadStats
+{
+	size_t numPackages = 0; // Packages opened by the preload
+	size_t prefetchBytes = 0; // Object data the OS was asked to read ahead of deserialization
+	double tablesTime = 0.0; // Milliseconds spent mapping the packages and parsing their tables
+	double prefetchTime = 0.0; // Milliseconds spent issuing the prefetch requests
+};
+
 class PackageManager
 {
 public:
 	PackageManager(const GameLaunchInfo& launchInfo);
+	~PackageManager();
 
 	bool IsUnreal1() const { return launchInfo.gameExecutableName == "Unreal"; }
 	bool IsUnreal1_226() const { return IsUnreal1() && launchInfo.engineVersion == 226; }
@@ -37,7 +50,17 @@ public:
 
 	void UnloadPackage(const NameString& name);
 
+	// Opens the map package and the packages it imports objects from before the objects are loaded.
+	// The files are paged in on the worker threads, while the tables are read on the calling thread.
+	PackagePreloadStats PreloadPackages(const NameString& name);
+
+	static double GetLoadTime(); // In milliseconds, for the load timings
+
+	TransientPackage* GetTransientPackage() { return transientPackage.get(); }
+	std::vector<Package*> GetLoadedPackages();
+
 	std::shared_ptr<PackageStream> GetStream(Package* package);
+	std::shared_ptr<MappedFile> GetMappedFile(Package* package);
 
 	UObject* NewObject(const NameString& name, const NameString& package, const NameString& className);
 	UObject* NewObject(const NameString& name, UClass* cls);
@@ -66,6 +89,7 @@ private:
 	void LoadEngineIniFiles();
 	void LoadIntFiles();
 	void LoadPackageRemaps();
+	void LoadPropertyOffsets();
 	std::map<NameString, std::string> ParseIntPublicValue(const std::string& value);
 
 	void ScanForMaps();
@@ -81,8 +105,10 @@ private:
 
 	std::map<NameString, std::string> packageFilenames;
 	std::map<NameString, std::unique_ptr<Package>> packages;
+	std::unique_ptr<TransientPackage> transientPackage; // Declared after packages so its objects are destroyed before their classes
 	std::map<NameString, std::unique_ptr<IniFile>> iniFiles;
-	std::map<NameString, std::unique_ptr<IniFile>> intFiles;
+	std::map<NameString, std::unique_ptr<IniFile>> intFiles; // Loaded on first use
+	std::map<NameString, std::string> intFilenames;
 	std::map<std::string, std::string> packageRemaps;
 
 	std::map<NameString, std::vector<IntObject>> IntObjects;
@@ -95,13 +121,10 @@ private:
 
 	bool missing_se_system_ini = false;
 
-	struct OpenStream
-	{
-		Package* Pkg = nullptr;
-		std::shared_ptr<PackageStream> Stream;
-	};
+	// Package files stay mapped until the package is unloaded. A mapping doesn't keep a file descriptor open.
+	std::map<NameString, std::shared_ptr<MappedFile>> mappedFiles;
 
-	std::list<OpenStream> openStreams;
+	std::unique_ptr<PackageCache> cache;
 
 	GameLaunchInfo launchInfo;
 
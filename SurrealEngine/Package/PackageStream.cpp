@@ -3,14 +3,18 @@
 #include "PackageStream.h"
 #include "Package.h"
 #include "File.h"
+#include <string.h>
 
-PackageStream::PackageStream(Package* package, std::shared_ptr<File> file) : package(package), file(file)
+PackageStream::PackageStream(Package* package, std::shared_ptr<MappedFile> file) : package(package), file(file), data(file->data()), size(file->size())
 {
 }
 
 void PackageStream::ReadBytes(void* d, uint32_t s)
 {
-	file->read(d, s);
+	if (pos + s > size)
+		throw std::runtime_error("PackageStream: Unexpected end of file in " + package->GetPackageName().ToString());
+	memcpy(d, data + pos, s);
+	pos += s;
 }
 
 int8_t PackageStream::ReadInt8()
@@ -70,17 +74,19 @@ uint64_t PackageStream::ReadUInt64()
 
 void PackageStream::Seek(uint32_t offset)
 {
-	file->seek(offset);
+	if (offset > size)
+		throw std::runtime_error("PackageStream::Seek: Unexpected end of file in " + package->GetPackageName().ToString());
+	pos = offset;
 }
 
 void PackageStream::Skip(uint32_t bytes)
 {
-	file->seek(file->tell());
+	Seek((uint32_t)(pos + bytes));
 }
 
 uint32_t PackageStream::Tell()
 {
-	return (uint32_t)file->tell();
+	return (uint32_t)pos;
 }
 
 int32_t PackageStream::ReadIndex()
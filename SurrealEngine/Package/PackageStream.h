@@ -1,12 +1,12 @@
 #pragma once
 
-class File;
+class MappedFile;
 class Package;
 
 class PackageStream
 {
 public:
-	PackageStream(Package* package, std::shared_ptr<File> file);
+	PackageStream(Package* package, std::shared_ptr<MappedFile> file);
 
 	void ReadBytes(void* d, uint32_t s);
 
@@ -31,5 +31,8 @@ public:
 
 private:
 	Package* package;
-	std::shared_ptr<File> file;
+	std::shared_ptr<MappedFile> file;
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+	size_t pos = 0;
 };
@@ -0,0 +1,187 @@
+
+#include "Precomp.h"
+#include "TransientPackage.h"
+#include "PackageManager.h"
+#include "Package.h"
+#include "UObject/UObject.h"
+#include "UObject/UClass.h"
+#include "UObject/UActor.h"
+#include "GC/GC.h"
+#include <algorithm>
+
+TransientPackage::TransientPackage(PackageManager* packageManager) : Packages(packageManager)
+{
+}
+
+TransientPackage::~TransientPackage()
+{
+	Objects.clear();
+	for (auto& it : FreeBlocks)
+	{
+		for (void* block : it.second)
+			delete[](int64_t*)block;
+	}
+}
+
+UObject* TransientPackage::NewObject(const NameString& name, UClass* cls, ObjectFlags flags)
+{
+	UObject* obj = Packages->GetPackage("Engine")->NewObject(name, cls, flags, false);
+	Objects.emplace_back(obj);
+
+	obj->PropertyData.Init(cls, AllocBlock((cls->StructSize + 7) / 8));
+	obj->SyncNativeProperties();
+	return obj;
+}
+
+static void ClearReferences(void* data, const ObjectReferenceLayout& layout, const std::vector<UObject*>& released)
+{
+	uint8_t* d = static_cast<uint8_t*>(data);
+	for (size_t offset : layout.Objects)
+	{
+		UObject*& ref = *reinterpret_cast<UObject**>(d + offset);
+		if (ref && std::binary_search(released.begin(), released.end(), ref))
+			ref = nullptr;
+	}
+
+	for (auto& array : layout.Arrays)
+	{
+		for (void* element : *reinterpret_cast<std::vector<void*>*>(d + array.first))
+			ClearReferences(element, *array.second, released);
+	}
+}
+
+static void ClearReferences(UObject* obj, const std::vector<UObject*>& released)
+{
+	if (obj->PropertyData.Data && obj->PropertyData.Class)
+		ClearReferences(obj->PropertyData.Data, obj->PropertyData.Class->GetReferenceLayout(), released);
+}
+
+void TransientPackage::ReleaseActors(const std::vector<UActor*>& destroyed)
+{
+	if (destroyed.empty())
+		return;
+
+	std::vector<UObject*> released(destroyed.begin(), destroyed.end());
+	std::sort(released.begin(), released.end());
+	GC::NoteReleased(released);
+
+	std::vector<std::unique_ptr<UObject>> releasedObjects = TakeObjects(released);
+	ClearReferences(released, nullptr);
+	FreeObjects(releasedObjects);
+}
+
+void TransientPackage::ReleasePackage(Package* package, ULevel* level)
+{
+	std::vector<UObject*> packageObjects;
+	for (auto& obj : package->GetObjects())
+	{
+		if (obj)
+			packageObjects.push_back(obj.get());
+	}
+	std::sort(packageObjects.begin(), packageObjects.end());
+
+	std::vector<UObject*> released;
+	for (auto& obj : Objects)
+	{
+		UActor* actor = UObject::TryCast<UActor>(obj.get());
+		if ((actor && actor->XLevel() == level) || std::binary_search(packageObjects.begin(), packageObjects.end(), obj->Class))
+			released.push_back(obj.get());
+	}
+	std::sort(released.begin(), released.end());
+
+	std::vector<std::unique_ptr<UObject>> releasedObjects = TakeObjects(released);
+
+	// The objects of the package itself are freed when it is unloaded
+	size_t count = released.size();
+	released.insert(released.end(), packageObjects.begin(), packageObjects.end());
+	std::inplace_merge(released.begin(), released.begin() + count, released.end());
+	ClearReferences(released, package);
+
+	FreeObjects(releasedObjects);
+}
+
+void TransientPackage::ReleaseObjects(const std::vector<UObject*>& objects)
+{
+	if (objects.empty())
+		return;
+
+	std::vector<std::unique_ptr<UObject>> releasedObjects = TakeObjects(objects);
+	FreeObjects(releasedObjects);
+}
+
+void TransientPackage::ClearReferences(const std::vector<UObject*>& released, Package* skipPackage)
+{
+	for (auto& obj : Objects)
+		::ClearReferences(obj.get(), released);
+
+	for (Package* package : Packages->GetLoadedPackages())
+	{
+		if (package == skipPackage)
+			continue;
+
+		for (auto& obj : package->GetObjects())
+		{
+			if (obj)
+				::ClearReferences(obj.get(), released);
+		}
+	}
+}
+
+std::vector<std::unique_ptr<UObject>> TransientPackage::TakeObjects(const std::vector<UObject*>& objects)
+{
+	std::vector<std::unique_ptr<UObject>> taken;
+	size_t count = 0;
+	for (size_t i = 0; i < Objects.size(); i++)
+	{
+		if (std::binary_search(objects.begin(), objects.end(), Objects[i].get()))
+			taken.push_back(std::move(Objects[i]));
+		else if (count != i)
+			Objects[count++] = std::move(Objects[i]);
+		else
+			count++;
+	}
+	Objects.resize(count);
+	return taken;
+}
+
+void TransientPackage::FreeObjects(std::vector<std::unique_ptr<UObject>>& objects)
+{
+	for (auto& obj : objects)
+	{
+		size_t size = obj->PropertyData.Size / 8;
+		void* block = obj->PropertyData.Release();
+		if (block)
+			FreeBlock(block, size);
+		obj.reset();
+	}
+	objects.clear();
+}
+
+size_t TransientPackage::GetFreeBlockCount() const
+{
+	size_t count = 0;
+	for (auto& it : FreeBlocks)
+		count += it.second.size();
+	return count;
+}
+
+void* TransientPackage::AllocBlock(size_t size)
+{
+	auto it = FreeBlocks.find(size);
+	if (it != FreeBlocks.end() && !it->second.empty())
+	{
+		void* block = it->second.back();
+		it->second.pop_back();
+		return block;
+	}
+	return new int64_t[size];
+}
+
+void TransientPackage::FreeBlock(void* block, size_t size)
+{
+	std::vector<void*>& blocks = FreeBlocks[size];
+	if (blocks.size() < MaxFreeBlocks)
+		blocks.push_back(block);
+	else
+		delete[](int64_t*)block;
+}
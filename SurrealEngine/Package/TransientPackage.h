@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ObjectFlags.h"
+#include "NameString.h"
+#include <unordered_map>
+
+class PackageManager;
+class Package;
+class UObject;
+class UClass;
+class UActor;
+class ULevel;
+
+// Owns the objects created at runtime: spawned actors, objects created by script and the engine's own objects.
+// The property data of released objects is kept in free lists and reused by the next object of the same size.
+class TransientPackage
+{
+public:
+	TransientPackage(PackageManager* packageManager);
+	~TransientPackage();
+
+	UObject* NewObject(const NameString& name, UClass* cls, ObjectFlags flags);
+
+	// Sets all references to the destroyed actors to None and frees the actors created here.
+	// The references are cleared in the transient objects and in every object loaded from a package. No script may be running.
+	void ReleaseActors(const std::vector<UActor*>& destroyed);
+
+	// Frees the actors spawned in the level and the objects whose class comes from the package, and sets all references to them
+	// and to the objects of the package to None. Must be called before the package is unloaded, as freeing the objects needs their classes.
+	void ReleasePackage(Package* package, ULevel* level);
+
+	// Frees unreachable objects found by the garbage collector. The list must be sorted.
+	void ReleaseObjects(const std::vector<UObject*>& objects);
+
+	const std::vector<std::unique_ptr<UObject>>& GetObjects() const { return Objects; }
+
+	size_t GetObjectCount() const { return Objects.size(); }
+	size_t GetFreeBlockCount() const;
+
+private:
+	std::vector<std::unique_ptr<UObject>> TakeObjects(const std::vector<UObject*>& objects);
+	void ClearReferences(const std::vector<UObject*>& released, Package* skipPackage);
+	void FreeObjects(std::vector<std::unique_ptr<UObject>>& objects);
+	void* AllocBlock(size_t size);
+	void FreeBlock(void* block, size_t size);
+
+	PackageManager* Packages = nullptr;
+	std::vector<std::unique_ptr<UObject>> Objects;
+	std::unordered_map<size_t, std::vector<void*>> FreeBlocks;
+
+	static const size_t MaxFreeBlocks = 256;
+
+	TransientPackage(const TransientPackage&) = delete;
+	TransientPackage& operator=(const TransientPackage&) = delete;
+};
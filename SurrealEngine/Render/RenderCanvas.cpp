@@ -6,6 +6,8 @@
 #include "Window/Window.h"
 #include "VM/ScriptCall.h"
 #include "Engine.h"
+#include "Package/PackageManager.h"
+#include "HeapAllocationCounter.h"
 
 void RenderSubsystem::ResetCanvas()
 {
@@ -400,6 +402,9 @@ void RenderSubsystem::DrawTimedemoStats()
 		lines.push_back(std::to_string(Scene.OpaqueNodes.size() + Scene.TranslucentNodes.size()) + " visible surfaces");
 		lines.push_back(std::to_string(Scene.Actors.size()) + " visible actors");
 		lines.push_back(std::to_string(Scene.Coronas.size()) + " visible coronas");
+		if (HeapAllocationCounter::IsEnabled())
+			lines.push_back(std::to_string(engine->TickHeapAllocations) + " tick allocations");
+		lines.push_back(std::to_string(engine->packages->GetTransientPackage()->GetObjectCount()) + " transient objects");
 
 		UFont* font = engine->canvas->SmallFont();
 		if (font)
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+class ULevel;
+class UClass;
+class UActor;
+
+// Walks the live actors of a class and any class derived from it, in Actors order.
+// Like a walk over Actors, it sees actors spawned during the walk and skips the ones destroyed before they are reached.
+// The per-class lists of the level are merged with a heap, unless the class covers much of the level. Then Actors is walked directly.
+class ActorClassCursor
+{
+public:
+	ActorClassCursor(ULevel* level, UClass* cls);
+	UActor* Next();
+
+private:
+	struct ListPosition
+	{
+		const std::vector<UActor*>* List = nullptr;
+		size_t Index = 0;
+		int LevelIndex = 0; // Of the actor at Index when it was pushed
+
+		bool operator<(const ListPosition& other) const { return LevelIndex > other.LevelIndex; } // Makes the std heap functions a min-heap
+	};
+
+	void UpdateLists();
+	void Push(ListPosition pos);
+
+	enum { MaxMergedLists = 16 };
+
+	ULevel* Level = nullptr;
+	UClass* Class = nullptr;
+
+	bool WalkActors = false;
+	size_t ActorsIndex = 0;
+
+	std::vector<const std::vector<UActor*>*> KnownLists;
+	std::vector<ListPosition> Heap;
+	std::vector<ListPosition> Finished; // Walked to the end. Actors spawned later are appended to them.
+	size_t ActorsSize = 0; // Level->Actors.size() when Finished was last looked at
+	uint32_t ListsSerial = 0;
+};
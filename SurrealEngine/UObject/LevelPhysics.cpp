@@ -0,0 +1,43 @@
+
+#include "Precomp.h"
+#include "LevelPhysics.h"
+#include "ULevel.h"
+#include "UActor.h"
+
+static_assert(PHYS_Trailer < 12, "LevelPhysics::ModeActors is too small");
+
+bool LevelPhysics::FixedStep = false;
+
+void LevelPhysics::Tick(ULevel* level, float elapsed)
+{
+	TimeLeft += elapsed;
+	while (TimeLeft >= StepTime)
+	{
+		Step(level);
+		TimeLeft -= StepTime;
+	}
+}
+
+void LevelPhysics::Step(ULevel* level)
+{
+	for (auto& list : ModeActors)
+		list.clear();
+
+	for (UActor* actor : level->Actors)
+	{
+		if (actor && !actor->bDeleteMe() && actor->Physics() != PHYS_None && actor->Physics() <= PHYS_Trailer)
+			ModeActors[actor->Physics()].push_back(actor);
+	}
+
+	// Each actor steps once, in the order of the mode it had when the step began.
+	// Script events raised by a move can change the mode, velocity or acceleration of actors that haven't moved yet.
+	// TickPhysicsStep reads all of them when the actor's turn comes, so the actor steps in its current state.
+	for (int mode = PHYS_Walking; mode <= PHYS_Trailer; mode++)
+	{
+		for (UActor* actor : ModeActors[mode])
+		{
+			if (!actor->bDeleteMe())
+				actor->TickPhysicsStep(StepTime);
+		}
+	}
+}
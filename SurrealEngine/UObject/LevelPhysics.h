@@ -0,0 +1,28 @@
+#pragma once
+
+class ULevel;
+class UActor;
+
+// Level wide physics stepper.
+// When FixedStep is enabled, ULevel::Tick advances the physics of all actors together in fixed 0.02 second steps instead of
+// inside each UActor::Tick. The step length does not depend on the frame rate, so the same input gives the same result on replay.
+//
+// Actors of one mode step together, but each one still runs the regular per-actor physics and collision code. Moves raise script
+// events that change other actors' velocity, mode and position, and later moves in the same step must see those changes.
+// That rules out integrating from packed per-mode arrays or tracing all moves of a step against one collision snapshot.
+class LevelPhysics
+{
+public:
+	static bool FixedStep;
+	static constexpr float StepTime = 0.02f;
+
+	void Tick(ULevel* level, float elapsed);
+
+private:
+	void Step(ULevel* level);
+
+	float TimeLeft = 0.0f;
+
+	// Actors grouped by physics mode at the start of the step
+	std::vector<UActor*> ModeActors[12];
+};
@@ -2,6 +2,7 @@
 #include "Precomp.h"
 #include "PropertyOffsets.h"
 #include "Package/PackageManager.h"
+#include "Package/PackageCache.h"
 #include "UClass.h"
 #include "UProperty.h"
 
@@ -2515,3 +2516,117 @@ void InitPropertyOffsets(PackageManager* packages)
 	InitPropertyOffsets_UdpLink(packages);
 	InitPropertyOffsets_TcpLink(packages);
 }
+
+static const std::pair<void*, size_t> PropertyOffsetsBlocks[] =
+{
+	{ &PropOffsets_Object, sizeof(PropOffsets_Object) },
+	{ &PropOffsets_Commandlet, sizeof(PropOffsets_Commandlet) },
+	{ &PropOffsets_Subsystem, sizeof(PropOffsets_Subsystem) },
+	{ &PropOffsets_HelloWorldCommandlet, sizeof(PropOffsets_HelloWorldCommandlet) },
+	{ &PropOffsets_SimpleCommandlet, sizeof(PropOffsets_SimpleCommandlet) },
+	{ &PropOffsets_Pawn, sizeof(PropOffsets_Pawn) },
+	{ &PropOffsets_Actor, sizeof(PropOffsets_Actor) },
+	{ &PropOffsets_LevelInfo, sizeof(PropOffsets_LevelInfo) },
+	{ &PropOffsets_Inventory, sizeof(PropOffsets_Inventory) },
+	{ &PropOffsets_PlayerPawn, sizeof(PropOffsets_PlayerPawn) },
+	{ &PropOffsets_PlayerReplicationInfo, sizeof(PropOffsets_PlayerReplicationInfo) },
+	{ &PropOffsets_Weapon, sizeof(PropOffsets_Weapon) },
+	{ &PropOffsets_GameInfo, sizeof(PropOffsets_GameInfo) },
+	{ &PropOffsets_ZoneInfo, sizeof(PropOffsets_ZoneInfo) },
+	{ &PropOffsets_Canvas, sizeof(PropOffsets_Canvas) },
+	{ &PropOffsets_SavedMove, sizeof(PropOffsets_SavedMove) },
+	{ &PropOffsets_StatLog, sizeof(PropOffsets_StatLog) },
+	{ &PropOffsets_Texture, sizeof(PropOffsets_Texture) },
+	{ &PropOffsets_Ammo, sizeof(PropOffsets_Ammo) },
+	{ &PropOffsets_NavigationPoint, sizeof(PropOffsets_NavigationPoint) },
+	{ &PropOffsets_Mutator, sizeof(PropOffsets_Mutator) },
+	{ &PropOffsets_Mover, sizeof(PropOffsets_Mover) },
+	{ &PropOffsets_HUD, sizeof(PropOffsets_HUD) },
+	{ &PropOffsets_Decoration, sizeof(PropOffsets_Decoration) },
+	{ &PropOffsets_TestInfo, sizeof(PropOffsets_TestInfo) },
+	{ &PropOffsets_GameReplicationInfo, sizeof(PropOffsets_GameReplicationInfo) },
+	{ &PropOffsets_Menu, sizeof(PropOffsets_Menu) },
+	{ &PropOffsets_LiftExit, sizeof(PropOffsets_LiftExit) },
+	{ &PropOffsets_Trigger, sizeof(PropOffsets_Trigger) },
+	{ &PropOffsets_Player, sizeof(PropOffsets_Player) },
+	{ &PropOffsets_LocalMessage, sizeof(PropOffsets_LocalMessage) },
+	{ &PropOffsets_locationid, sizeof(PropOffsets_locationid) },
+	{ &PropOffsets_Carcass, sizeof(PropOffsets_Carcass) },
+	{ &PropOffsets_InterpolationPoint, sizeof(PropOffsets_InterpolationPoint) },
+	{ &PropOffsets_Projectile, sizeof(PropOffsets_Projectile) },
+	{ &PropOffsets_Teleporter, sizeof(PropOffsets_Teleporter) },
+	{ &PropOffsets_Palette, sizeof(PropOffsets_Palette) },
+	{ &PropOffsets_SpawnNotify, sizeof(PropOffsets_SpawnNotify) },
+	{ &PropOffsets_Fragment, sizeof(PropOffsets_Fragment) },
+	{ &PropOffsets_WarpZoneInfo, sizeof(PropOffsets_WarpZoneInfo) },
+	{ &PropOffsets_Console, sizeof(PropOffsets_Console) },
+	{ &PropOffsets_PlayerStart, sizeof(PropOffsets_PlayerStart) },
+	{ &PropOffsets_Pickup, sizeof(PropOffsets_Pickup) },
+	{ &PropOffsets_Brush, sizeof(PropOffsets_Brush) },
+	{ &PropOffsets_ScoreBoard, sizeof(PropOffsets_ScoreBoard) },
+	{ &PropOffsets_Spectator, sizeof(PropOffsets_Spectator) },
+	{ &PropOffsets_InventorySpot, sizeof(PropOffsets_InventorySpot) },
+	{ &PropOffsets_Decal, sizeof(PropOffsets_Decal) },
+	{ &PropOffsets_PatrolPoint, sizeof(PropOffsets_PatrolPoint) },
+	{ &PropOffsets_Counter, sizeof(PropOffsets_Counter) },
+	{ &PropOffsets_Bitmap, sizeof(PropOffsets_Bitmap) },
+	{ &PropOffsets_MapList, sizeof(PropOffsets_MapList) },
+	{ &PropOffsets_Effects, sizeof(PropOffsets_Effects) },
+	{ &PropOffsets_StatLogFile, sizeof(PropOffsets_StatLogFile) },
+	{ &PropOffsets_LevelSummary, sizeof(PropOffsets_LevelSummary) },
+	{ &PropOffsets_ScriptedTexture, sizeof(PropOffsets_ScriptedTexture) },
+	{ &PropOffsets_Engine, sizeof(PropOffsets_Engine) },
+	{ &PropOffsets_TriggerLight, sizeof(PropOffsets_TriggerLight) },
+	{ &PropOffsets_SpecialEvent, sizeof(PropOffsets_SpecialEvent) },
+	{ &PropOffsets_RoundRobin, sizeof(PropOffsets_RoundRobin) },
+	{ &PropOffsets_MusicEvent, sizeof(PropOffsets_MusicEvent) },
+	{ &PropOffsets_HomeBase, sizeof(PropOffsets_HomeBase) },
+	{ &PropOffsets_Dispatcher, sizeof(PropOffsets_Dispatcher) },
+	{ &PropOffsets_DemoRecSpectator, sizeof(PropOffsets_DemoRecSpectator) },
+	{ &PropOffsets_DamageType, sizeof(PropOffsets_DamageType) },
+	{ &PropOffsets_Ambushpoint, sizeof(PropOffsets_Ambushpoint) },
+	{ &PropOffsets_WarpZoneMarker, sizeof(PropOffsets_WarpZoneMarker) },
+	{ &PropOffsets_LiftCenter, sizeof(PropOffsets_LiftCenter) },
+	{ &PropOffsets_RenderIterator, sizeof(PropOffsets_RenderIterator) },
+	{ &PropOffsets_FractalTexture, sizeof(PropOffsets_FractalTexture) },
+	{ &PropOffsets_WaterTexture, sizeof(PropOffsets_WaterTexture) },
+	{ &PropOffsets_WaveTexture, sizeof(PropOffsets_WaveTexture) },
+	{ &PropOffsets_FireTexture, sizeof(PropOffsets_FireTexture) },
+	{ &PropOffsets_WetTexture, sizeof(PropOffsets_WetTexture) },
+	{ &PropOffsets_IceTexture, sizeof(PropOffsets_IceTexture) },
+	{ &PropOffsets_InternetLink, sizeof(PropOffsets_InternetLink) },
+	{ &PropOffsets_UdpLink, sizeof(PropOffsets_UdpLink) },
+	{ &PropOffsets_TcpLink, sizeof(PropOffsets_TcpLink) },
+};
+
+// Version of the data written by SavePropertyOffsets
+static const uint32_t PropertyOffsetsFormatVersion = 1;
+
+// FNV-1a hash of the class and property names in declaration order. Together with the struct sizes it identifies the layout.
+static const uint64_t PropertyOffsetsLayoutHash = 0xc65cbb8e1ed65aa2ULL;
+
+void SavePropertyOffsets(CacheWriter& writer)
+{
+	writer.WriteUInt32(PropertyOffsetsFormatVersion);
+	writer.WriteUInt64(PropertyOffsetsLayoutHash);
+	writer.WriteUInt32((uint32_t)(sizeof(PropertyOffsetsBlocks) / sizeof(PropertyOffsetsBlocks[0])));
+	for (const auto& block : PropertyOffsetsBlocks)
+	{
+		writer.WriteUInt64(block.second);
+		writer.WriteBytes(block.first, block.second);
+	}
+}
+
+bool LoadPropertyOffsets(CacheReader& reader)
+{
+	if (reader.ReadUInt32() != PropertyOffsetsFormatVersion || reader.ReadUInt64() != PropertyOffsetsLayoutHash || reader.ReadUInt32() != sizeof(PropertyOffsetsBlocks) / sizeof(PropertyOffsetsBlocks[0]))
+		return false;
+
+	for (const auto& block : PropertyOffsetsBlocks)
+	{
+		if (reader.ReadUInt64() != block.second)
+			return false;
+		reader.ReadBytes(block.first, block.second);
+	}
+	return true;
+}
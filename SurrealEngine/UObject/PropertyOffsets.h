@@ -1,8 +1,12 @@
 #pragma once
 
 class PackageManager;
+class CacheReader;
+class CacheWriter;
 
 void InitPropertyOffsets(PackageManager* packages);
+void SavePropertyOffsets(CacheWriter& writer);
+bool LoadPropertyOffsets(CacheReader& reader);
 
 struct PropertyDataOffset
 {
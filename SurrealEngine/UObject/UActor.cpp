@@ -8,6 +8,7 @@
 #include "VM/Frame.h"
 #include "Package/PackageManager.h"
 #include "Engine.h"
+#include "Audio/AudioSubsystem.h"
 #include "Collision/OverlapCylinderLevel.h"
 
 static std::string tickEventName = "Tick";
@@ -15,13 +16,13 @@ static std::string tickEventName = "Tick";
 // TODO: Compare behavior more closely with original engine. Might differ depending on game.
 static constexpr float stepDownDeltaFactor = 1.3f;
 
-static void ApplyRotationPhysics(UActor& actor, float elapsed)
+// Returns true if the rotation reached DesiredRotation, which fires EndedRotation
+static bool StepRotation(UActor& actor, Rotator& rot, float elapsed)
 {
 	if (actor.bRotateToDesired())
 	{
-		if (actor.Rotation() != actor.DesiredRotation())
+		if (rot != actor.DesiredRotation())
 		{
-			Rotator rot = actor.Rotation();
 			if (actor.bFixedRotationDir())
 			{
 				rot.Yaw = Rotator::TurnToFixed(rot.Yaw, actor.DesiredRotation().Yaw, (int)(actor.RotationRate().Yaw * elapsed));
@@ -34,18 +35,29 @@ static void ApplyRotationPhysics(UActor& actor, float elapsed)
 				rot.Pitch = Rotator::TurnToShortest(rot.Pitch, actor.DesiredRotation().Pitch, (int)std::abs(actor.RotationRate().Pitch * elapsed));
 				rot.Roll = Rotator::TurnToShortest(rot.Roll, actor.DesiredRotation().Roll, (int)std::abs(actor.RotationRate().Roll * elapsed));
 			}
-			actor.Rotation() = rot;
-
-			if (actor.Rotation() == actor.DesiredRotation())
-			{
-				CallEvent(&actor, EventName::EndedRotation);
-			}
+			return rot == actor.DesiredRotation();
 		}
 	}
 	else if (actor.bFixedRotationDir())
 	{
-		actor.Rotation() += actor.RotationRate() * elapsed;
+		rot += actor.RotationRate() * elapsed;
 	}
+	return false;
+}
+
+// Rotator's operator== ignores whole turns. Prepared steps have to match exactly.
+static bool IsSameRotator(const Rotator& a, const Rotator& b)
+{
+	return a.Pitch == b.Pitch && a.Yaw == b.Yaw && a.Roll == b.Roll;
+}
+
+static void ApplyRotationPhysics(UActor& actor, float elapsed)
+{
+	Rotator rot = actor.Rotation();
+	bool arrived = StepRotation(actor, rot, elapsed);
+	actor.Rotation() = rot;
+	if (arrived)
+		CallEvent(&actor, EventName::EndedRotation);
 }
 
 UActor* UActor::Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTag, vec3* SpawnLocation, Rotator* SpawnRotation)
@@ -58,10 +70,11 @@ UActor* UActor::Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTa
 	vec3 location = SpawnLocation ? *SpawnLocation : Location();
 	Rotator rotation = SpawnRotation ? *SpawnRotation : Rotation();
 
-	float radius = SpawnClass->GetDefaultObject()->GetFloat("CollisionRadius");
-	float height = SpawnClass->GetDefaultObject()->GetFloat("CollisionHeight");
-	bool bCollideWorld = SpawnClass->GetDefaultObject()->GetBool("bCollideWorld");
-	bool bCollideWhenPlacing = SpawnClass->GetDefaultObject()->GetBool("bCollideWhenPlacing");
+	static const NameString CollisionRadiusProp("CollisionRadius"), CollisionHeightProp("CollisionHeight"), bCollideWorldProp("bCollideWorld"), bCollideWhenPlacingProp("bCollideWhenPlacing");
+	float radius = SpawnClass->GetDefaultObject()->GetFloat(CollisionRadiusProp);
+	float height = SpawnClass->GetDefaultObject()->GetFloat(CollisionHeightProp);
+	bool bCollideWorld = SpawnClass->GetDefaultObject()->GetBool(bCollideWorldProp);
+	bool bCollideWhenPlacing = SpawnClass->GetDefaultObject()->GetBool(bCollideWhenPlacingProp);
 	if (bCollideWorld || bCollideWhenPlacing)
 	{
 		auto result = CheckLocation(location, radius, height, bCollideWorld || bCollideWhenPlacing);
@@ -70,8 +83,7 @@ UActor* UActor::Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTa
 		location = result.second;
 	}
 
-	// To do: package needs to be grabbed from outer, or the "transient package" if it is None, a virtual package for runtime objects
-	UActor* actor = UObject::Cast<UActor>(engine->packages->GetPackage("Engine")->NewObject("", UObject::Cast<UClass>(SpawnClass), ObjectFlags::Transient, true));
+	UActor* actor = UObject::Cast<UActor>(engine->packages->GetTransientPackage()->NewObject("", SpawnClass, ObjectFlags::Transient));
 
 	actor->Outer() = XLevel()->Outer();
 	actor->XLevel() = XLevel();
@@ -85,7 +97,7 @@ UActor* UActor::Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTa
 	actor->Rotation() = rotation;
 	actor->Region().Zone = actor->Level();
 
-	XLevel()->Actors.push_back(actor);
+	XLevel()->AddActor(actor);
 	XLevel()->Hash.AddToCollision(actor);
 
 	actor->SetOwner(SpawnOwner ? SpawnOwner : this);
@@ -122,7 +134,7 @@ UActor* UActor::Spawn(UClass* SpawnClass, UActor* SpawnOwner, NameString SpawnTa
 				for (USpawnNotify* notifyObj = Level()->SpawnNotify(); notifyObj != nullptr; notifyObj = notifyObj->Next())
 				{
 					UClass* cls = notifyObj->ActorClass();
-					if (cls && actor->IsA(cls->Name))
+					if (cls && actor->IsA(cls))
 						actor = UObject::Cast<UGameInfo>(CallEvent(notifyObj, EventName::SpawnNotification, { ExpressionValue::ObjectValue(actor) }).ToObject());
 				}
 			}
@@ -229,19 +241,20 @@ bool UActor::Destroy()
 
 	SetOwner(nullptr);
 
-	for (size_t i = 0; i < level->Actors.size(); i++)
+	std::vector<UActor*> children;
+	children.swap(ChildActors);
+	for (UActor* child : children)
 	{
-		UActor* actor = level->Actors[i];
-		if (actor && actor->Owner() == this)
-		{
-			actor->SetOwner(nullptr);
-		}
-		if (actor == this)
-		{
-			level->Actors[i] = nullptr;
-		}
+		if (child->Owner() == this)
+			child->SetOwner(nullptr);
 	}
 
+	level->RemoveActor(this);
+
+	if (engine->audio)
+		engine->audio->NoteDestroy(this);
+
+	level->DestroyedActors.push_back(this);
 	return true;
 }
 
@@ -284,6 +297,10 @@ void UActor::SetOwner(UActor* newOwner)
 		Owner()->RemoveChildActor(this);
 	}
 
+	// A destroyed actor is freed soon, so it must not end up in the child list of a live actor or the other way around
+	if (bDeleteMe() || (newOwner && newOwner->bDeleteMe()))
+		newOwner = nullptr;
+
 	Owner() = newOwner;
 
 	if (Owner())
@@ -350,7 +367,16 @@ void UActor::Tick(float elapsed, bool tickedFlag)
 {
 	bTicked() = tickedFlag;
 
-	TickAnimation(elapsed);
+	if (PreparedAnim.Valid && PreparedAnim.FromFrame == AnimFrame() && PreparedAnim.Rate == AnimRate() && PreparedAnim.Sequence == AnimSequence() &&
+		PreparedAnim.Last == AnimLast() && PreparedAnim.Loop == bAnimLoop() && PreparedAnim.Mesh == Mesh() && PreparedAnim.Notify == bAnimNotify())
+	{
+		AnimFrame() = PreparedAnim.ToFrame;
+	}
+	else
+	{
+		TickAnimation(elapsed);
+	}
+	PreparedAnim.Valid = false;
 
 	if (Role() >= ROLE_SimulatedProxy && IsEventEnabled(EventName::Tick))
 	{
@@ -369,7 +395,20 @@ void UActor::Tick(float elapsed, bool tickedFlag)
 		StateFrame->Tick();
 	}
 
-	TickPhysics(elapsed);
+	if (!LevelPhysics::FixedStep)
+	{
+		if (PreparedPhysics.Valid && !bDeleteMe() && Physics() == PHYS_Rotating && !PendingTouch() && IsSameRotator(Rotation(), PreparedPhysics.FromRotation) &&
+			IsSameRotator(DesiredRotation(), PreparedPhysics.DesiredRotation) && IsSameRotator(RotationRate(), PreparedPhysics.RotationRate) &&
+			bRotateToDesired() == PreparedPhysics.RotateToDesired && bFixedRotationDir() == PreparedPhysics.FixedRotationDir)
+		{
+			Rotation() = PreparedPhysics.ToRotation;
+		}
+		else
+		{
+			TickPhysics(elapsed);
+		}
+	}
+	PreparedPhysics.Valid = false;
 
 	if (TimerRate() > 0.0f) // Role() == ROLE_Authority && RemoteRole() == ROLE_AutonomousProxy
 	{
@@ -388,38 +427,47 @@ void UActor::TickPhysics(float elapsed)
 {
 	for (float timeLeft = elapsed; timeLeft > 0.0f && !bDeleteMe(); timeLeft -= 0.02f)
 	{
-		float physTimeElapsed = std::min(timeLeft, 0.02f);
-		int mode = Physics();
-		if (mode != PHYS_None)
+		TickPhysicsStep(std::min(timeLeft, 0.02f));
+	}
+}
+
+void UActor::TickPhysicsStep(float physTimeElapsed)
+{
+	int mode = Physics();
+	if (mode != PHYS_None)
+	{
+		switch (mode)
 		{
-			switch (mode)
-			{
-			case PHYS_Walking: TickWalking(physTimeElapsed); break;
-			case PHYS_Falling: TickFalling(physTimeElapsed); break;
-			case PHYS_Swimming: TickSwimming(physTimeElapsed); break;
-			case PHYS_Flying: TickFlying(physTimeElapsed); break;
-			case PHYS_Rotating: TickRotating(physTimeElapsed); break;
-			case PHYS_Projectile: TickProjectile(physTimeElapsed); break;
-			case PHYS_Rolling: TickRolling(physTimeElapsed); break;
-			case PHYS_Interpolating: TickInterpolating(physTimeElapsed); break;
-			case PHYS_MovingBrush: TickMovingBrush(physTimeElapsed); break;
-			case PHYS_Spider: TickSpider(physTimeElapsed); break;
-			case PHYS_Trailer: TickTrailer(physTimeElapsed); break;
-			}
+		case PHYS_Walking: TickWalking(physTimeElapsed); break;
+		case PHYS_Falling: TickFalling(physTimeElapsed); break;
+		case PHYS_Swimming: TickSwimming(physTimeElapsed); break;
+		case PHYS_Flying: TickFlying(physTimeElapsed); break;
+		case PHYS_Rotating: TickRotating(physTimeElapsed); break;
+		case PHYS_Projectile: TickProjectile(physTimeElapsed); break;
+		case PHYS_Rolling: TickRolling(physTimeElapsed); break;
+		case PHYS_Interpolating: TickInterpolating(physTimeElapsed); break;
+		case PHYS_MovingBrush: TickMovingBrush(physTimeElapsed); break;
+		case PHYS_Spider: TickSpider(physTimeElapsed); break;
+		case PHYS_Trailer: TickTrailer(physTimeElapsed); break;
 		}
+	}
+
+	DispatchPendingTouch();
+}
 
-		if (engine->LaunchInfo.engineVersion >= 400)
+void UActor::DispatchPendingTouch()
+{
+	if (engine->LaunchInfo.engineVersion >= 400)
+	{
+		if (PendingTouch())
 		{
+			CallEvent(PendingTouch(), EventName::PostTouch, { ExpressionValue::ObjectValue(this) });
 			if (PendingTouch())
 			{
-				CallEvent(PendingTouch(), EventName::PostTouch, { ExpressionValue::ObjectValue(this) });
-				if (PendingTouch())
-				{
-					UActor* cur = PendingTouch();
-					UActor* next = cur->PendingTouch();
-					PendingTouch() = next;
-					cur->PendingTouch() = nullptr;
-				}
+				UActor* cur = PendingTouch();
+				UActor* next = cur->PendingTouch();
+				PendingTouch() = next;
+				cur->PendingTouch() = nullptr;
 			}
 		}
 	}
@@ -832,7 +880,6 @@ void UActor::TickProjectile(float elapsed)
 
 	UZoneInfo* zone = Region().Zone;
 	UProjectile* projectile = UObject::TryCast<UProjectile>(this);
-	UPawn* pawn = UObject::TryCast<UPawn>(this);
 
 	if (zone->bWaterZone())
 		Velocity() = Velocity() * std::max(1.0f - zone->ZoneFluidFriction() * 0.2f * elapsed, 0.0f);
@@ -888,7 +935,8 @@ void UActor::TickInterpolating(float elapsed)
 			UPlayerPawn* pawn = static_cast<UPlayerPawn*>(this);
 			pawn->DesiredFlashScale() = mix(target->ScreenFlashScale(), next->ScreenFlashScale(), physAlpha);
 			pawn->DesiredFlashFog() = mix(target->ScreenFlashFog(), next->ScreenFlashFog(), physAlpha);
-			pawn->FovAngle() = mix(target->FovModifier(), next->FovModifier(), physAlpha) * Class->GetDefaultObject()->GetFloat("FovAngle");
+			static const NameString FovAngleProp("FovAngle");
+			pawn->FovAngle() = mix(target->FovModifier(), next->FovModifier(), physAlpha) * Class->GetDefaultObject()->GetFloat(FovAngleProp);
 			pawn->FlashScale() = vec3(pawn->DesiredFlashScale());
 			pawn->FlashFog() = pawn->DesiredFlashFog();
 		}
@@ -1080,11 +1128,10 @@ void UActor::SetPhysics(uint8_t newPhysics)
 
 void UActor::SetCollision(bool newColActors, bool newBlockActors, bool newBlockPlayers)
 {
-	XLevel()->Hash.RemoveFromCollision(this);
 	bCollideActors() = newColActors;
 	bBlockActors() = newBlockActors;
 	bBlockPlayers() = newBlockPlayers;
-	XLevel()->Hash.AddToCollision(this);
+	XLevel()->Hash.UpdateCollision(this);
 }
 
 bool UActor::SetLocation(const vec3& newLocation)
@@ -1093,9 +1140,8 @@ bool UActor::SetLocation(const vec3& newLocation)
 	if (!result.first)
 		return false;
 
-	XLevel()->Hash.RemoveFromCollision(this);
 	Location() = result.second;
-	XLevel()->Hash.AddToCollision(this);
+	XLevel()->Hash.UpdateCollision(this);
 
 	if (Level()->bBegunPlay())
 	{
@@ -1134,10 +1180,9 @@ bool UActor::SetCollisionSize(float newRadius, float newHeight)
 {
 	// To do: return false if there isn't room
 
-	XLevel()->Hash.RemoveFromCollision(this);
 	CollisionRadius() = newRadius;
 	CollisionHeight() = newHeight;
-	XLevel()->Hash.AddToCollision(this);
+	XLevel()->Hash.UpdateCollision(this);
 	return true;
 }
 
@@ -1160,7 +1205,8 @@ UObject* UActor::Trace(vec3& hitLocation, vec3& hitNormal, const vec3& traceEnd,
 	}
 
 	// hack?
-	if (IsA("ChallengeHUD"))
+	static const NameString ChallengeHUDName("ChallengeHUD");
+	if (IsA(ChallengeHUDName))
 	{
 		flags.zoneChanges = true;
 	}
@@ -1176,6 +1222,11 @@ bool UActor::FastTrace(const vec3& traceEnd, const vec3& traceStart)
 	return !XLevel()->TraceRayAnyHit(traceStart, traceEnd, this, false, true, false);
 }
 
+void UActor::FastTraces(TraceRayQuery* rays, size_t count)
+{
+	XLevel()->TraceRaysAnyHit(rays, count, false, true, false);
+}
+
 bool UActor::IsBasedOn(UActor* other)
 {
 	for (UActor* cur = other; cur; cur = cur->ActorBase())
@@ -1256,9 +1307,8 @@ CollisionHit UActor::TryMove(const vec3& delta, bool dryRun)
 	vec3 actuallyMoved = delta * blockingHit.Fraction;
 	vec3 OldLocation = Location();
 
-	XLevel()->Hash.RemoveFromCollision(this);
 	Location() += actuallyMoved;
-	XLevel()->Hash.AddToCollision(this);
+	XLevel()->Hash.UpdateCollision(this);
 
 	// Based actors needs to move with us
 	if (StandingCount() > 0)
@@ -1574,6 +1624,77 @@ void UActor::TweenAnim(const NameString& sequence, float tweenTime)
 	}
 }
 
+void UActor::PrepareAnimation(float elapsed)
+{
+	// This runs on the worker threads. It may only read this actor and must leave anything that fires an event to TickAnimation.
+
+	PreparedAnim.Valid = false;
+
+	float fromAnimTime = AnimFrame();
+	float animRate = AnimRate();
+	if (elapsed <= 0.0f || fromAnimTime < 0.0f || animRate < 0.0f)
+		return;
+
+	float toAnimTime = fromAnimTime + animRate * elapsed;
+	if (animRate != 0.0f)
+	{
+		if (Mesh() && bAnimNotify())
+		{
+			MeshAnimSeq* seq = Mesh()->GetSequence(AnimSequence());
+			if (seq)
+			{
+				for (const MeshAnimNotify& n : seq->Notifys)
+				{
+					if (n.Time > fromAnimTime && n.Time <= toAnimTime)
+						return;
+				}
+			}
+		}
+
+		if (bAnimLoop() && AnimLast() > fromAnimTime && AnimLast() <= toAnimTime)
+			return;
+
+		float animEndTime = bAnimLoop() ? 1.0f : AnimLast();
+		if (toAnimTime >= animEndTime)
+			return;
+	}
+
+	PreparedAnim.Mesh = Mesh();
+	PreparedAnim.Sequence = AnimSequence();
+	PreparedAnim.FromFrame = fromAnimTime;
+	PreparedAnim.ToFrame = toAnimTime;
+	PreparedAnim.Rate = animRate;
+	PreparedAnim.Last = AnimLast();
+	PreparedAnim.Loop = bAnimLoop();
+	PreparedAnim.Notify = bAnimNotify();
+	PreparedAnim.Valid = true;
+}
+
+void UActor::PreparePhysics(float elapsed)
+{
+	// This runs on the worker threads. Only PHYS_Rotating is handled here, as every other mode moves the actor through the
+	// collision hash and can touch or bump other actors.
+
+	PreparedPhysics.Valid = false;
+	if (LevelPhysics::FixedStep || Physics() != PHYS_Rotating || PendingTouch())
+		return;
+
+	Rotator rot = Rotation();
+	for (float timeLeft = elapsed; timeLeft > 0.0f; timeLeft -= 0.02f)
+	{
+		if (StepRotation(*this, rot, std::min(timeLeft, 0.02f)))
+			return;
+	}
+
+	PreparedPhysics.FromRotation = Rotation();
+	PreparedPhysics.ToRotation = rot;
+	PreparedPhysics.DesiredRotation = DesiredRotation();
+	PreparedPhysics.RotationRate = RotationRate();
+	PreparedPhysics.RotateToDesired = bRotateToDesired();
+	PreparedPhysics.FixedRotationDir = bFixedRotationDir();
+	PreparedPhysics.Valid = true;
+}
+
 void UActor::TickAnimation(float elapsed)
 {
 	for (int i = 0; elapsed > 0.0f && i < 10; i++)
@@ -1772,17 +1893,39 @@ void UActor::MakeNoise(float loudness)
 		noisePawn->noise2loudness() = loudness;
 	}
 
+	// Trace the line of sight to all listeners in one batch
+	std::vector<UPawn*> listeners;
+	std::vector<TraceRayQuery> rays;
 	for (UPawn* pawn = Level()->PawnList(); pawn != nullptr; pawn = pawn->nextPawn())
 	{
-		if (pawn != noisePawn && pawn->CanHearNoise(this, loudness))
+		if (pawn != noisePawn && pawn->IsNoiseAudible(this, loudness))
 		{
-			CallEvent(pawn, EventName::HearNoise, { ExpressionValue::FloatValue(loudness), ExpressionValue::ObjectValue(this) });
+			TraceRayQuery ray;
+			ray.From = Location();
+			ray.To = pawn->Location();
+			ray.TracingActor = this;
+			listeners.push_back(pawn);
+			rays.push_back(ray);
+		}
+	}
+
+	if (listeners.empty())
+		return;
+
+	FastTraces(rays.data(), rays.size());
+
+	for (size_t i = 0; i < listeners.size(); i++)
+	{
+		if (!rays[i].Hit)
+		{
+			CallEvent(listeners[i], EventName::HearNoise, { ExpressionValue::FloatValue(loudness), ExpressionValue::ObjectValue(this) });
 		}
 	}
 }
 
 bool UActor::PlayerCanSeeMe()
 {
+	std::vector<TraceRayQuery> rays;
 	for (UPawn* pawn = Level()->PawnList(); pawn != nullptr; pawn = pawn->nextPawn())
 	{
 		if (pawn == this)
@@ -1803,10 +1946,21 @@ bool UActor::PlayerCanSeeMe()
 				continue;
 		}
 
-		// Try check for line of sight
+		// Queue the line of sight check
 		vec3 eyePos = pawn->Location();
 		eyePos.z += pawn->BaseEyeHeight();
-		if (pawn->FastTrace(Location(), eyePos))
+		TraceRayQuery ray;
+		ray.From = eyePos;
+		ray.To = Location();
+		ray.TracingActor = pawn;
+		rays.push_back(ray);
+	}
+
+	FastTraces(rays.data(), rays.size());
+
+	for (const TraceRayQuery& ray : rays)
+	{
+		if (!ray.Hit)
 			return true;
 	}
 	return false;
@@ -1814,6 +1968,13 @@ bool UActor::PlayerCanSeeMe()
 
 void UActor::UpdateBspInfo()
 {
+	// Destroyed actors are freed soon and must stay out of the node lists, even if script moves them
+	if (bDeleteMe())
+	{
+		RemoveFromBspNode();
+		return;
+	}
+
 	vec3 extents;
 	if (LightBrightness() == 0)
 	{
@@ -1971,6 +2132,14 @@ bool UPawn::LineOfSightTo(UActor* other)
 	if (!other)
 		return false;
 
+	TraceRayQuery rays[3];
+	GetSightRays(other, rays);
+	FastTraces(rays, 3);
+	return !rays[0].Hit || !rays[1].Hit || !rays[2].Hit;
+}
+
+void UPawn::GetSightRays(UActor* other, TraceRayQuery* rays)
+{
 	vec3 eye_pos = Location();
 	eye_pos.z += BaseEyeHeight();
 
@@ -1978,7 +2147,14 @@ bool UPawn::LineOfSightTo(UActor* other)
 	auto top = origin + vec3{ 0.f, 0.f, other->CollisionHeight() / 2 };
 	auto bottom = origin - vec3{ 0.f, 0.f, other->CollisionHeight() / 2 };
 
-	return FastTrace(origin, eye_pos) || FastTrace(top, eye_pos) || FastTrace(bottom, eye_pos);
+	vec3 targets[3] = { origin, top, bottom };
+	for (int i = 0; i < 3; i++)
+	{
+		rays[i].From = eye_pos;
+		rays[i].To = targets[i];
+		rays[i].TracingActor = this;
+		rays[i].Hit = false;
+	}
 }
 
 bool UPawn::CanSee(UActor* other)
@@ -1991,8 +2167,6 @@ bool UPawn::CanSee(UActor* other)
 	// float PeripheralVision: Cosine of limits of peripheral vision
 
 	auto& origin = other->Location();
-	auto top = origin + vec3{ 0.f, 0.f, other->CollisionHeight() / 2 };
-	auto bottom = origin - vec3{ 0.f, 0.f, other->CollisionHeight() / 2 };
 
 	vec3 eye_pos = Location();
 	eye_pos.z += BaseEyeHeight();
@@ -2015,15 +2189,23 @@ bool UPawn::CanSee(UActor* other)
 	if (peripheralVision > 0.0f && abs(cosine) > peripheralVision)
 		return false;
 
-	return FastTrace(origin, eye_pos) || FastTrace(top, eye_pos) || FastTrace(bottom, eye_pos);
+	TraceRayQuery rays[3];
+	GetSightRays(other, rays);
+	FastTraces(rays, 3);
+	return !rays[0].Hit || !rays[1].Hit || !rays[2].Hit;
 }
 
 bool UPawn::CanHearNoise(UActor* source, float loudness)
+{
+	return IsNoiseAudible(source, loudness) && !XLevel()->TraceRayAnyHit(source->Location(), Location(), source, false, true, false);
+}
+
+bool UPawn::IsNoiseAudible(UActor* source, float loudness)
 {
 	UPawn* noisePawn = UObject::Cast<UPawn>(source->Instigator());
 	if (!noisePawn->bIsPlayer() && (!noisePawn->Enemy() || !noisePawn->Enemy()->bIsPlayer()))
 	{
-		if (!IsA(source->Class->Name) && !source->IsA(Class->Name))
+		if (!IsA(source->Class) && !source->IsA(Class))
 			return false;
 	}
 	else if (UObject::TryCast<UPlayerPawn>(this))
@@ -2049,27 +2231,26 @@ bool UPawn::CanHearNoise(UActor* source, float loudness)
 		return false;
 	}
 
-	return !XLevel()->TraceRayAnyHit(source->Location(), Location(), source, false, true, false);
+	return true;
 }
 
 UActor* UPawn::PickAnyTarget(float& bestAim, float& bestDist, const vec3& FireDir, const vec3& projStart)
 {
-	UActor* bestActor = nullptr;
+	std::vector<UActor*> candidates;
 	for (UActor* actor : XLevel()->Actors)
 	{
 		// We are only looking for targets that isn't a pawn (pawn uses PickTarget if it wants a pawn)
 		if (!actor || actor == this || UObject::TryCast<UPawn>(actor) || !actor->bProjTarget())
 			continue;
 
-		if (CheckIfBestTarget(actor, bestAim, bestDist, FireDir, projStart))
-			bestActor = actor;
+		candidates.push_back(actor);
 	}
-	return bestActor;
+	return PickBestTarget(candidates, bestAim, bestDist, FireDir, projStart);
 }
 
 UActor* UPawn::PickTarget(float& bestAim, float& bestDist, const vec3& FireDir, const vec3& projStart)
 {
-	UActor* bestActor = nullptr;
+	std::vector<UActor*> candidates;
 	auto ourPlayerInfo = PlayerReplicationInfo();
 	bool teamGame = ourPlayerInfo && Level()->Game()->bTeamGame();
 	for (UPawn* pawn = Level()->PawnList(); pawn != nullptr; pawn = pawn->nextPawn())
@@ -2083,38 +2264,70 @@ UActor* UPawn::PickTarget(float& bestAim, float& bestDist, const vec3& FireDir,
 		if (teamGame && pawnPlayerInfo && ourPlayerInfo->Team() == pawnPlayerInfo->Team())
 			continue;
 
-		if (CheckIfBestTarget(pawn, bestAim, bestDist, FireDir, projStart))
-			bestActor = pawn;
+		candidates.push_back(pawn);
 	}
-	return bestActor;
+	return PickBestTarget(candidates, bestAim, bestDist, FireDir, projStart);
 }
 
-bool UPawn::CheckIfBestTarget(UActor* actor, float& bestAim, float& bestDist, const vec3& FireDir, const vec3& projStart)
+UActor* UPawn::PickBestTarget(const std::vector<UActor*>& candidates, float& bestAim, float& bestDist, const vec3& FireDir, const vec3& projStart)
 {
-	// Ignore targets behind us
-	vec3 delta = actor->Location() - projStart;
-	float angle = dot(FireDir, delta);
-	if (angle < 0.0f)
-		return false;
+	struct Target
+	{
+		UActor* Actor;
+		float Aim;
+		float Distance;
+	};
 
-	// Skip things too far away
-	float distance = length(delta);
-	if (distance == 0.0f || distance > 2500.0f)
-		return false;
+	std::vector<Target> targets;
+	for (UActor* actor : candidates)
+	{
+		// Ignore targets behind us
+		vec3 delta = actor->Location() - projStart;
+		float angle = dot(FireDir, delta);
+		if (angle < 0.0f)
+			continue;
 
-	// Skip if we already have a target closer to the direction we are facing
-	angle /= distance;
-	if (angle < bestAim)
-		return false;
+		// Skip things too far away
+		float distance = length(delta);
+		if (distance == 0.0f || distance > 2500.0f)
+			continue;
 
-	// Skip if we can't see the target
-	if (!LineOfSightTo(actor))
-		return false;
+		// Skip if we already have a target closer to the direction we are facing
+		angle /= distance;
+		if (angle < bestAim)
+			continue;
 
-	// OK, this is better than what we have
-	bestAim = angle;
-	bestDist = distance;
-	return true;
+		targets.push_back({ actor, angle, distance });
+	}
+
+	// Best aim first. On a tie the later candidate wins.
+	std::reverse(targets.begin(), targets.end());
+	std::stable_sort(targets.begin(), targets.end(), [](const Target& a, const Target& b) { return a.Aim > b.Aim; });
+
+	// Check line of sight a few targets at a time, so the sight rays are traced together
+	const size_t batchSize = 8;
+	TraceRayQuery rays[batchSize * 3];
+	for (size_t start = 0; start < targets.size(); start += batchSize)
+	{
+		size_t count = std::min(targets.size() - start, batchSize);
+		for (size_t i = 0; i < count; i++)
+			GetSightRays(targets[start + i].Actor, rays + i * 3);
+
+		FastTraces(rays, count * 3);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const TraceRayQuery* sight = rays + i * 3;
+			if (!sight[0].Hit || !sight[1].Hit || !sight[2].Hit)
+			{
+				const Target& target = targets[start + i];
+				bestAim = target.Aim;
+				bestDist = target.Distance;
+				return target.Actor;
+			}
+		}
+	}
+	return nullptr;
 }
 
 void UPawn::InitActorZone()
@@ -2299,7 +2512,7 @@ bool UPawn::TickRotateTo(const vec3& target)
 
 	DesiredRotation() = Rotator::FromVector(target - Location());
 
-	if (Physics() == PHYS_Walking && (!MoveTarget() || !MoveTarget()->IsA("Pawn")))
+	if (Physics() == PHYS_Walking && (!MoveTarget() || !MoveTarget()->IsA(EngineClass.Pawn)))
 	{
 		DesiredRotation().Pitch = 0;
 	}
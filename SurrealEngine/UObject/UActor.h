@@ -28,6 +28,7 @@ class UMover;
 class UTrigger;
 class UWarpZoneInfo;
 class UZoneInfo;
+class TraceRayQuery;
 class PackageManager;
 class CollisionHit;
 class BspNode;
@@ -162,8 +163,12 @@ public:
 	virtual void Tick(float elapsed, bool tickedFlag);
 
 	void TickAnimation(float elapsed);
+	void PrepareAnimation(float elapsed);
+	void PreparePhysics(float elapsed);
 
 	void TickPhysics(float elapsed);
+	void TickPhysicsStep(float elapsed);
+	void DispatchPendingTouch();
 	void TickWalking(float elapsed);
 	void TickFalling(float elapsed);
 	void TickSwimming(float elapsed);
@@ -192,6 +197,7 @@ public:
 
 	UObject* Trace(vec3& hitLocation, vec3& hitNormal, const vec3& traceEnd, const vec3& traceStart, bool bTraceActors, const vec3& extent);
 	bool FastTrace(const vec3& traceEnd, const vec3& traceStart);
+	void FastTraces(TraceRayQuery* rays, size_t count);
 
 	CollisionHit TryMove(const vec3 & delta, bool dryRun = false);
 	CollisionHit TryMoveSmooth(const vec3& delta);
@@ -258,6 +264,32 @@ public:
 		UActor* Next = nullptr;
 	} BspInfo;
 
+	// Animation step computed ahead of the tick on a worker thread. Only used if the step fires no events and nothing changed the animation before Tick.
+	struct
+	{
+		bool Valid = false;
+		UMesh* Mesh = nullptr;
+		NameString Sequence;
+		float FromFrame = 0.0f;
+		float ToFrame = 0.0f;
+		float Rate = 0.0f;
+		float Last = 0.0f;
+		bool Loop = false;
+		bool Notify = false;
+	} PreparedAnim;
+
+	// PHYS_Rotating step computed ahead of the tick on a worker thread. Only used if it fires no events and nothing changed the rotation before Tick.
+	struct
+	{
+		bool Valid = false;
+		Rotator FromRotation;
+		Rotator ToRotation;
+		Rotator DesiredRotation;
+		Rotator RotationRate;
+		bool RotateToDesired = false;
+		bool FixedRotationDir = false;
+	} PreparedPhysics;
+
 	// Tweening animation state
 	struct
 	{
@@ -274,6 +306,11 @@ public:
 	// Child actor tracking
 	std::vector<UActor*> ChildActors;
 
+	int LevelIndex = -1; // Slot in XLevel()->Actors
+	int ClassActorsIndex = -1; // Slot in the level's list of actors with the same class
+	int TickDepth = 0; // Length of the owner/base chain. Owners and bases tick first.
+	uint32_t TickDepthSerial = 0; // Tick list TickDepth was calculated for
+
 	void AddChildActor(UActor* actor);
 	void RemoveChildActor(UActor* actor);
 
@@ -1665,12 +1702,15 @@ public:
 	// Similar to LineOfSightTo() but takes the Pawn's peripheral vision into account (SightRadius and PeripheralVision)
 	bool CanSee(UActor* other);
 	bool CanHearNoise(UActor* source, float loudness);
+	// CanHearNoise without the line of sight trace
+	bool IsNoiseAudible(UActor* source, float loudness);
 	bool ActorReachable(UActor* anActor);
 	bool PointReachable(vec3 aPoint);
 
 	UActor* PickAnyTarget(float& bestAim, float& bestDist, const vec3& FireDir, const vec3& projStart);
 	UActor* PickTarget(float& bestAim, float& bestDist, const vec3& FireDir, const vec3& projStart);
-	bool CheckIfBestTarget(UActor* actor, float& bestAim, float& bestDist, const vec3& FireDir, const vec3& projStart);
+	UActor* PickBestTarget(const std::vector<UActor*>& candidates, float& bestAim, float& bestDist, const vec3& FireDir, const vec3& projStart);
+	void GetSightRays(UActor* other, TraceRayQuery* rays);
 
 	float& AccelRate() { return Value<float>(PropOffsets_Pawn.AccelRate); }
 	float& AirControl() { return Value<float>(PropOffsets_Pawn.AirControl); }
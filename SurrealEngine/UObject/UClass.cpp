@@ -7,6 +7,9 @@
 #include "VM/NativeFunc.h"
 #include "VM/ScriptCall.h"
 #include "Package/PackageManager.h"
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
 
 void UField::Load(ObjectStream* stream)
 {
@@ -44,6 +47,83 @@ UStruct::UStruct(NameString name, UClass* cls, ObjectFlags flags, UStruct* base)
 	BaseStruct = base;
 }
 
+static void AddObjectReferences(ObjectReferenceLayout& layout, UProperty* prop, size_t offset)
+{
+	if (dynamic_cast<UClassProperty*>(prop))
+	{
+		// Classes are owned by their packages
+	}
+	else if (dynamic_cast<UObjectProperty*>(prop))
+	{
+		for (uint32_t i = 0; i < prop->ArrayDimension; i++)
+			layout.Objects.push_back(offset + i * sizeof(void*));
+	}
+	else if (UFixedArrayProperty* fixedArray = dynamic_cast<UFixedArrayProperty*>(prop))
+	{
+		size_t size = fixedArray->Inner->Size();
+		for (uint32_t i = 0, count = fixedArray->Count * fixedArray->ArrayDimension; i < count; i++)
+			AddObjectReferences(layout, fixedArray->Inner, offset + i * size);
+	}
+	else if (UStructProperty* structProp = dynamic_cast<UStructProperty*>(prop))
+	{
+		if (!structProp->Struct)
+			return;
+
+		const ObjectReferenceLayout& members = structProp->Struct->GetReferenceLayout();
+		for (uint32_t i = 0; i < prop->ArrayDimension; i++)
+		{
+			size_t base = offset + i * structProp->Struct->StructSize;
+			for (size_t member : members.Objects)
+				layout.Objects.push_back(base + member);
+			for (auto& member : members.Arrays)
+				layout.Arrays.push_back({ base + member.first, member.second });
+		}
+	}
+	else if (UArrayProperty* arrayProp = dynamic_cast<UArrayProperty*>(prop))
+	{
+		auto element = std::make_shared<ObjectReferenceLayout>();
+		AddObjectReferences(*element, arrayProp->Inner, 0);
+		if (element->Objects.empty() && element->Arrays.empty())
+			return;
+
+		for (uint32_t i = 0; i < prop->ArrayDimension; i++)
+			layout.Arrays.push_back({ offset + i * sizeof(std::vector<void*>), element });
+	}
+}
+
+const ObjectReferenceLayout& UStruct::GetReferenceLayout()
+{
+	if (!ReferenceLayout)
+	{
+		auto layout = std::make_unique<ObjectReferenceLayout>();
+		for (UProperty* prop : Properties)
+			AddObjectReferences(*layout, prop, prop->DataOffset.DataOffset);
+		ReferenceLayout = std::move(layout);
+	}
+	return *ReferenceLayout;
+}
+
+// Bump this when the way Load assigns property data offsets changes
+static const int PropertyLayoutVersion = 1;
+
+std::string UStruct::GetPropertyLayoutStamp()
+{
+	std::string stamp = "layout " + std::to_string(PropertyLayoutVersion);
+	for (size_t size : { sizeof(void*), sizeof(NameString), sizeof(std::string), sizeof(std::vector<void*>), sizeof(std::map<void*, void*>) })
+		stamp += " " + std::to_string(size);
+
+	// The sizes of the standard containers can change with the build configuration without changing the values above
+#if defined(_ITERATOR_DEBUG_LEVEL)
+	stamp += " idl" + std::to_string(_ITERATOR_DEBUG_LEVEL);
+#endif
+#if defined(_DEBUG)
+	stamp += " debug";
+#elif defined(NDEBUG)
+	stamp += " release";
+#endif
+	return stamp;
+}
+
 void UStruct::Load(ObjectStream* stream)
 {
 	UField::Load(stream);
@@ -364,6 +444,35 @@ void UFunction::Load(ObjectStream* stream)
 	FuncFlags = (FunctionFlags)stream->ReadUInt32();
 	if (AllFlags(FuncFlags, FunctionFlags::Net))
 		ReplicationOffset = stream->ReadUInt16();
+
+	InitParms();
+}
+
+void UFunction::InitParms()
+{
+	for (UField* field = Children; field != nullptr; field = field->Next)
+	{
+		UProperty* prop = dynamic_cast<UProperty*>(field);
+		if (prop)
+		{
+			if (AllFlags(prop->PropFlags, PropertyFlags::Parm))
+			{
+				FunctionParm parm;
+				parm.Property = prop;
+				parm.OptionalParm = AllFlags(prop->PropFlags, PropertyFlags::OptionalParm);
+				parm.OutParm = AllFlags(prop->PropFlags, PropertyFlags::OutParm);
+				parm.ReturnParm = AllFlags(prop->PropFlags, PropertyFlags::ReturnParm);
+				Parms.push_back(parm);
+
+				if (parm.ReturnParm)
+					ReturnParm = prop;
+			}
+			else
+			{
+				LocalVariables.push_back(prop);
+			}
+		}
+	}
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -387,10 +496,80 @@ void UState::Load(ObjectStream* stream)
 
 /////////////////////////////////////////////////////////////////////////////
 
+static std::vector<UClass*> AllClasses;
+static int ClassTreeVersion = 1;
+static std::mutex ClassTreeMutex;
+
 UClass::UClass(NameString name, UClass* base, ObjectFlags flags) : UState(std::move(name), this, flags, base)
 {
 	if (base)
 		ClsFlags = base->ClsFlags;
+
+	std::unique_lock<std::mutex> lock(ClassTreeMutex);
+	AllClasses.push_back(this);
+	ClassTreeVersion++;
+}
+
+UClass::~UClass()
+{
+	std::unique_lock<std::mutex> lock(ClassTreeMutex);
+	auto it = std::find(AllClasses.begin(), AllClasses.end(), this);
+	if (it != AllClasses.end())
+	{
+		*it = AllClasses.back();
+		AllClasses.pop_back();
+	}
+	ClassTreeVersion++;
+}
+
+bool UClass::IsChildOf(const UClass* base) const
+{
+	if (ClassIntervalVersion != ClassTreeVersion || base->ClassIntervalVersion != ClassTreeVersion)
+		UpdateClassTree();
+	return ClassIntervalStart >= base->ClassIntervalStart && ClassIntervalStart < base->ClassIntervalEnd;
+}
+
+void UClass::UpdateClassTree()
+{
+	std::unique_lock<std::mutex> lock(ClassTreeMutex);
+	if (!AllClasses.empty() && AllClasses.front()->ClassIntervalVersion == ClassTreeVersion)
+		return;
+
+	std::unordered_map<const UClass*, std::vector<UClass*>> children;
+	std::vector<UClass*> stack;
+	for (UClass* cls : AllClasses)
+	{
+		if (cls->BaseStruct)
+			children[static_cast<UClass*>(cls->BaseStruct)].push_back(cls);
+		else
+			stack.push_back(cls);
+	}
+
+	// Iterative depth first walk. The class is pushed a second time to close its interval once all its children got numbered.
+	int index = 0;
+	std::vector<std::pair<UClass*, bool>> work;
+	for (UClass* root : stack)
+		work.push_back({ root, false });
+	while (!work.empty())
+	{
+		auto [cls, done] = work.back();
+		work.pop_back();
+		if (done)
+		{
+			cls->ClassIntervalEnd = index;
+			continue;
+		}
+
+		cls->ClassIntervalStart = index++;
+		cls->ClassIntervalVersion = ClassTreeVersion;
+		work.push_back({ cls, true });
+		auto it = children.find(cls);
+		if (it != children.end())
+		{
+			for (UClass* child : it->second)
+				work.push_back({ child, false });
+		}
+	}
 }
 
 void UClass::Load(ObjectStream* stream)
@@ -429,10 +608,8 @@ void UClass::Load(ObjectStream* stream)
 	PropertyData.Init(this);
 	PropertyData.ReadProperties(stream);
 
-	// Copy native UObject properties into the VM
-	SetObject("Class", this);
-	SetName("Name", Name);
-	SetInt("ObjectFlags", (int)Flags);
+	// Copy native UObject properties into the VM. The defaults of a class describe the class itself.
+	SyncNativeProperties(this);
 
 	auto packages = stream->GetPackage()->GetPackageManager();
 	NameString packageName = stream->GetPackage()->GetPackageName();
@@ -626,6 +803,19 @@ UProperty* UClass::GetProperty(const NameString& propName)
 	throw std::runtime_error("Class Property '" + Name.ToString() + "." + propName.ToString() + "' not found");
 }
 
+const std::vector<UFunction*>& UClass::GetEventTable(const NameString& stateName)
+{
+	auto it = EventTables.find(stateName);
+	if (it != EventTables.end())
+		return it->second;
+
+	std::vector<UFunction*>& table = EventTables[stateName];
+	table.resize((size_t)EventName::MaxEventNameValue);
+	for (int i = 0; i < (int)EventName::MaxEventNameValue; i++)
+		table[i] = FindEventFunction(this, stateName, ToNameString((EventName)i));
+	return table;
+}
+
 void UClass::SaveToConfig(PackageManager& packageManager)
 {
 	if (!(ClsFlags & ClassFlags::Config))
@@ -642,3 +832,19 @@ void UClass::SaveToConfig(PackageManager& packageManager)
 		}
 	}
 }
+
+/////////////////////////////////////////////////////////////////////////////
+
+EngineClasses EngineClass;
+
+static UClass* FindEngineClass(PackageManager* packages, const NameString& name)
+{
+	return dynamic_cast<UClass*>(packages->GetPackage("engine")->GetUObject("Class", name));
+}
+
+void InitEngineClasses(PackageManager* packages)
+{
+	EngineClass.Pawn = FindEngineClass(packages, "Pawn");
+	EngineClass.Mover = FindEngineClass(packages, "Mover");
+	EngineClass.ZoneInfo = FindEngineClass(packages, "ZoneInfo");
+}
@@ -7,6 +7,7 @@ class UStruct;
 class UProperty;
 enum class ExprToken : uint8_t;
 class Bytecode;
+class NativeFuncHandler;
 
 class UField : public UObject
 {
@@ -36,6 +37,13 @@ public:
 	std::vector<NameString> ElementNames;
 };
 
+// Where a block of property data stores its object references
+struct ObjectReferenceLayout
+{
+	std::vector<size_t> Objects; // Offsets of UObject pointers
+	std::vector<std::pair<size_t, std::shared_ptr<ObjectReferenceLayout>>> Arrays; // Offsets of dynamic arrays and the layout of their elements
+};
+
 class UStruct : public UField
 {
 public:
@@ -43,6 +51,9 @@ public:
 	UStruct(NameString name, UClass* cls, ObjectFlags flags, UStruct* base);
 	void Load(ObjectStream* stream) override;
 
+	// Describes everything besides the classes themselves that the property data offsets depend on
+	static std::string GetPropertyLayoutStamp();
+
 	UStruct* BaseStruct = nullptr;
 
 	UTextBuffer* ScriptText = nullptr;
@@ -60,7 +71,12 @@ public:
 	size_t StructSize = 0;
 	std::vector<UProperty*> Properties;
 
+	const ObjectReferenceLayout& GetReferenceLayout();
+
 private:
+	std::unique_ptr<ObjectReferenceLayout> ReferenceLayout; // Built on first use
+
+
 	ExprToken ReadToken(ObjectStream* stream, int depth);
 	void PushBytes(const void* data, size_t size);
 	void PushUInt8(uint8_t value);
@@ -98,6 +114,14 @@ inline FunctionFlags operator&(FunctionFlags a, FunctionFlags b) { return (Funct
 inline bool AllFlags(FunctionFlags value, FunctionFlags flags) { return (value & flags) == flags; }
 inline bool AnyFlags(FunctionFlags value, FunctionFlags flags) { return (uint32_t)(value & flags) != 0; }
 
+struct FunctionParm
+{
+	UProperty* Property = nullptr;
+	bool OptionalParm = false;
+	bool OutParm = false;
+	bool ReturnParm = false;
+};
+
 class UFunction : public UStruct
 {
 public:
@@ -113,6 +137,17 @@ public:
 	uint16_t ReplicationOffset = 0;
 
 	UStruct* NativeStruct = nullptr;
+
+	// Signature of the function, cached at load time so that calls don't have to search the children
+	std::vector<FunctionParm> Parms; // Parameters in declaration order, including the return value
+	std::vector<UProperty*> LocalVariables; // Properties that aren't parameters
+	UProperty* ReturnParm = nullptr;
+
+	// Resolved on first call by Frame::Call
+	const NativeFuncHandler* NativeHandler = nullptr;
+
+private:
+	void InitParms();
 };
 
 enum class ScriptStateFlags : uint32_t
@@ -178,8 +213,12 @@ class UClass : public UState
 {
 public:
 	UClass(NameString name, UClass* base, ObjectFlags flags);
+	~UClass() override;
 	void Load(ObjectStream* stream) override;
 
+	// True if this class is base or derives from it
+	bool IsChildOf(const UClass* base) const;
+
 	UProperty* GetProperty(const NameString& name);
 	UObject* GetDefaultObject() { return this; }
 
@@ -196,10 +235,34 @@ public:
 	UState* GetState(const NameString& name) { auto it = States.find(name); if (it != States.end()) return it->second; else return nullptr; }
 	std::map<NameString, UState*> States;
 
+	// Event functions indexed by EventName, including inherited overrides and state functions for the given state
+	const std::vector<UFunction*>& GetEventTable(const NameString& stateName);
+
 private:
+	std::map<NameString, std::vector<UFunction*>> EventTables;
+
 	std::map<NameString, std::string> ParseStructValue(const std::string& text);
+
+	static void UpdateClassTree();
+
+	// Pre-order numbering of the class tree. Every class derived from this one is numbered in [ClassIntervalStart, ClassIntervalEnd).
+	int ClassIntervalStart = 0;
+	int ClassIntervalEnd = 0;
+	int ClassIntervalVersion = 0;
+};
+
+// Engine classes that native code tests actors against. Null if the class isn't in the loaded game.
+struct EngineClasses
+{
+	UClass* Pawn = nullptr;
+	UClass* Mover = nullptr;
+	UClass* ZoneInfo = nullptr;
 };
 
+extern EngineClasses EngineClass;
+
+void InitEngineClasses(PackageManager* packages);
+
 enum class ExprToken : uint8_t
 {
 	// Variable references
@@ -8,21 +8,14 @@
 #include "Collision/TraceRayLevel.h"
 #include "Collision/TraceRayModel.h"
 #include "Collision/TraceCylinderLevel.h"
+#include "JobSystem.h"
+#include "Engine.h"
+#include "Package/PackageManager.h"
+#include <algorithm>
 
 BBox BspNode::GetCollisionBox(UModel* model) const
 {
-	int32_t* hullIndexList = &model->LeafHulls[CollisionBound];
-	int hullPlanesCount = 0;
-	while (hullIndexList[hullPlanesCount] >= 0)
-		hullPlanesCount++;
-
-	vec3* bboxStart = (vec3*)(&hullIndexList[hullPlanesCount + 1]);
-
-	BBox bbox;
-	bbox.min = bboxStart[0];
-	bbox.max = bboxStart[1];
-
-	return bbox;
+	return model->CollisionHulls[CollisionHull].Bounds;
 }
 
 void ULevelBase::Load(ObjectStream* stream)
@@ -59,6 +52,17 @@ void ULevel::Load(ObjectStream* stream)
 {
 	ULevelBase::Load(stream);
 
+	for (size_t i = 0; i < Actors.size(); i++)
+	{
+		if (Actors[i])
+		{
+			Actors[i]->LevelIndex = (int)i;
+			AddClassActor(Actors[i]);
+		}
+		else
+			EmptyActorSlots++;
+	}
+
 	int count = stream->ReadIndex();
 	for (int i = 0; i < count; i++)
 	{
@@ -83,36 +87,199 @@ void ULevel::Load(ObjectStream* stream)
 
 void ULevel::Tick(float elapsed)
 {
-	// To do: owned actors must tick before their children:
-	for (size_t i = 0; i < Actors.size(); i++)
+	size_t actorCount = Actors.size();
+	BuildTickList();
+
+	// Event free native work runs on the worker threads first. UActor::Tick applies the results on the main thread.
+	JobSystem::ParallelFor(TickList.size(), 64, [&](size_t start, size_t end)
+		{
+			for (size_t i = start; i < end; i++)
+			{
+				TickList[i]->PrepareAnimation(elapsed);
+				TickList[i]->PreparePhysics(elapsed);
+			}
+		});
+
+	for (UActor* actor : TickList)
+	{
+		if (!actor->bDeleteMe())
+			TickActor(actor, elapsed);
+	}
+
+	// Actors spawned during this tick
+	for (size_t i = actorCount; i < Actors.size(); i++)
 	{
 		UActor* actor = Actors[i];
+		if (actor)
+			TickActor(actor, elapsed);
+	}
+
+	if (LevelPhysics::FixedStep)
+		Physics.Tick(this, elapsed);
+
+	// Destroyed actors leave empty slots behind. Compacting only once a quarter of the list is empty keeps the cost per destroy constant.
+	if (EmptyActorSlots >= 64 && EmptyActorSlots * 4 >= Actors.size())
+		CompactActors();
+
+	// Releasing looks through all objects for references to the destroyed actors, so it is done in batches
+	ReleaseCountdown -= elapsed;
+	if (ReleaseCountdown <= 0.0f)
+	{
+		ReleaseDestroyedActors();
+		ReleaseCountdown = 0.25f;
+	}
+
+	ticked = !ticked;
+}
+
+void ULevel::ReleaseDestroyedActors()
+{
+	// Script may have moved the actors after they were destroyed
+	for (UActor* actor : DestroyedActors)
+	{
+		actor->RemoveFromBspNode();
+		Hash.RemoveFromCollision(actor);
+	}
+
+	engine->packages->GetTransientPackage()->ReleaseActors(DestroyedActors);
+	DestroyedActors.clear();
+}
+
+void ULevel::AddActor(UActor* actor)
+{
+	actor->LevelIndex = (int)Actors.size();
+	Actors.push_back(actor);
+	AddClassActor(actor);
+}
+
+void ULevel::RemoveActor(UActor* actor)
+{
+	int index = actor->LevelIndex;
+	if (index >= 0 && (size_t)index < Actors.size() && Actors[index] == actor)
+	{
+		Actors[index] = nullptr;
+		EmptyActorSlots++;
+		RemoveClassActor(actor);
+	}
+	actor->LevelIndex = -1;
+}
+
+void ULevel::AddClassActor(UActor* actor)
+{
+	auto result = ClassActors.try_emplace(actor->Class);
+	if (result.second)
+		ClassActorsSerial++;
+
+	std::vector<UActor*>& list = result.first->second;
+	actor->ClassActorsIndex = (int)list.size();
+	list.push_back(actor);
+}
+
+void ULevel::RemoveClassActor(UActor* actor)
+{
+	auto it = ClassActors.find(actor->Class);
+	int index = actor->ClassActorsIndex;
+	if (it != ClassActors.end() && index >= 0 && (size_t)index < it->second.size() && it->second[index] == actor)
+		it->second[index] = nullptr;
+	actor->ClassActorsIndex = -1;
+}
+
+std::vector<UActor*> ULevel::GetActorsOfClass(UClass* cls)
+{
+	std::vector<UActor*> result;
+	if (!cls)
+		return result;
+
+	ActorClassCursor cursor(this, cls);
+	while (UActor* actor = cursor.Next())
+		result.push_back(actor);
+	return result;
+}
+
+void ULevel::CompactActors()
+{
+	// The actors keep their order, as it is also the tick order
+	size_t count = 0;
+	for (UActor* actor : Actors)
+	{
 		if (actor)
 		{
-			actor->Tick(elapsed, ticked);
+			actor->LevelIndex = (int)count;
+			Actors[count++] = actor;
+		}
+	}
+	Actors.resize(count);
+	EmptyActorSlots = 0;
 
-			if (actor->Role() >= ROLE_SimulatedProxy && actor->LifeSpan() != 0.0f)
+	for (auto& it : ClassActors)
+	{
+		std::vector<UActor*>& list = it.second;
+		count = 0;
+		for (UActor* actor : list)
+		{
+			if (actor)
 			{
-				actor->LifeSpan() = std::max(actor->LifeSpan() - elapsed, 0.0f);
-				if (actor->LifeSpan() == 0.0f)
-				{
-					CallEvent(actor, EventName::Expired);
-					actor->Destroy();
-				}
+				actor->ClassActorsIndex = (int)count;
+				list[count++] = actor;
 			}
 		}
+		list.resize(count);
 	}
+}
+
+void ULevel::TickActor(UActor* actor, float elapsed)
+{
+	actor->Tick(elapsed, ticked);
 
-	std::vector<UActor*> newActorList;
-	newActorList.reserve(Actors.size());
+	if (actor->Role() >= ROLE_SimulatedProxy && actor->LifeSpan() != 0.0f)
+	{
+		actor->LifeSpan() = std::max(actor->LifeSpan() - elapsed, 0.0f);
+		if (actor->LifeSpan() == 0.0f)
+		{
+			CallEvent(actor, EventName::Expired);
+			actor->Destroy();
+		}
+	}
+}
+
+static uint32_t TickDepthSerial = 0;
+static const int MaxTickDepth = 8;
+
+static int GetTickDepth(UActor* actor, int limit)
+{
+	if (!actor || limit == 0)
+		return 0;
+
+	// Each actor is only walked once per tick list. Marking it before the walk also cuts off cycles in the owner/base chain.
+	if (actor->TickDepthSerial == TickDepthSerial)
+		return actor->TickDepth;
+	actor->TickDepthSerial = TickDepthSerial;
+	actor->TickDepth = 0;
+
+	if (actor->Owner() || actor->ActorBase())
+		actor->TickDepth = std::min(std::max(GetTickDepth(actor->Owner(), limit - 1), GetTickDepth(actor->ActorBase(), limit - 1)) + 1, MaxTickDepth);
+	return actor->TickDepth;
+}
+
+void ULevel::BuildTickList()
+{
+	// Owners and bases tick before the actors attached to them. Otherwise the actors keep their order in the level.
+	TickDepthSerial++;
+	size_t start[MaxTickDepth + 2] = {};
 	for (UActor* actor : Actors)
 	{
 		if (actor)
-			newActorList.push_back(actor);
+			start[GetTickDepth(actor, MaxTickDepth) + 1]++;
 	}
-	Actors.swap(newActorList);
+	for (int depth = 1; depth <= MaxTickDepth + 1; depth++)
+		start[depth] += start[depth - 1];
 
-	ticked = !ticked;
+	TickList.resize(start[MaxTickDepth + 1]);
+	for (UActor* actor : Actors)
+	{
+		if (actor)
+			TickList[start[actor->TickDepth]++] = actor;
+	}
 }
 
 CollisionHit ULevel::TraceFirstHit(const vec3& from, const vec3& to, UActor* tracingActor, const vec3& extents, const TraceFlags& flags)
@@ -121,17 +288,17 @@ CollisionHit ULevel::TraceFirstHit(const vec3& from, const vec3& to, UActor* tra
 	{
 		if (hit.Actor && (!tracingActor || !tracingActor->IsOwnedBy(hit.Actor)))
 		{
-			if (hit.Actor->IsA("Pawn"))
+			if (hit.Actor->IsA(EngineClass.Pawn))
 			{
 				if (flags.pawns)
 					return hit;
 			}
-			else if (hit.Actor->IsA("Mover"))
+			else if (hit.Actor->IsA(EngineClass.Mover))
 			{
 				if (flags.movers)
 					return hit;
 			}
-			else if (hit.Actor->IsA("ZoneInfo"))
+			else if (hit.Actor->IsA(EngineClass.ZoneInfo))
 			{
 				if (flags.zoneChanges)
 					return hit;
@@ -165,6 +332,12 @@ bool ULevel::TraceRayAnyHit(vec3 from, vec3 to, UActor* tracingActor, bool trace
 	return trace.TraceAnyHit(this, from, to, tracingActor, traceActors, traceWorld, visibilityOnly);
 }
 
+void ULevel::TraceRaysAnyHit(TraceRayQuery* rays, size_t count, bool traceActors, bool traceWorld, bool visibilityOnly)
+{
+	TraceRayLevel trace;
+	trace.TraceAnyHit(this, rays, count, traceActors, traceWorld, visibilityOnly);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 
 void UModel::Load(ObjectStream* stream)
@@ -349,6 +522,113 @@ void UModel::Load(ObjectStream* stream)
 
 	RootOutside = stream->ReadInt32();
 	Linked = stream->ReadInt32();
+
+	BuildCollisionHulls();
+}
+
+static bool GetBevelPlane(const dvec4& plane0, const dvec4& plane1, const dvec3& bevelDirection, dvec4& bevelplane)
+{
+	dvec3 cross1 = cross(bevelDirection, plane0.xyz());
+	dvec3 cross2 = cross(bevelDirection, plane1.xyz());
+	if (dot(cross1, cross2) <= 0.00001)
+		return false;
+
+	dvec3 linedir = cross(plane0.xyz(), plane1.xyz());
+	double length2 = dot(linedir, linedir);
+	if (length2 < 0.000001)
+		return false;
+
+	dvec3 point = (plane0.w * cross(plane1.xyz(), linedir) + plane1.w * cross(linedir, plane0.xyz())) / length2;
+	linedir = normalize(linedir);
+
+	dvec3 normal = normalize(cross(bevelDirection, linedir));
+	if (dot(plane0.xyz(), normal) < 0.0)
+	{
+		normal = -normal;
+	}
+
+	bevelplane = dvec4(normal, dot(point, normal));
+	return true;
+}
+
+void UModel::BuildCollisionHulls()
+{
+	CollisionHulls.clear();
+	CollisionPlanes.clear();
+
+	std::unordered_map<int, int> hullIndices;
+	for (BspNode& node : Nodes)
+	{
+		if (node.CollisionBound < 0)
+		{
+			node.CollisionHull = -1;
+			continue;
+		}
+
+		auto it = hullIndices.find(node.CollisionBound);
+		if (it != hullIndices.end())
+		{
+			node.CollisionHull = it->second;
+			continue;
+		}
+
+		int32_t* hullIndexList = &LeafHulls[node.CollisionBound];
+		int hullPlanesCount = 0;
+		while (hullIndexList[hullPlanesCount] >= 0)
+			hullPlanesCount++;
+
+		vec3* bboxStart = (vec3*)(&hullIndexList[hullPlanesCount + 1]);
+
+		CollisionHull hull;
+		hull.Bounds.min = bboxStart[0];
+		hull.Bounds.max = bboxStart[1];
+
+		// Grab the hull planes and flip the plane direction if the plane points in the wrong direction.
+		hull.PlaneStart = (int)CollisionPlanes.size();
+		hull.PlaneCount = hullPlanesCount;
+		for (int i = 0; i < hullPlanesCount; i++)
+		{
+			int32_t hullIndex = hullIndexList[i];
+			bool hullFlip = !!(hullIndex & 0x4000'0000);
+			hullIndex = hullIndex & ~0x4000'0000;
+			BspNode* hullnode = &Nodes[hullIndex];
+			dvec4 hullplane((double)hullnode->PlaneX, (double)hullnode->PlaneY, (double)hullnode->PlaneZ, (double)hullnode->PlaneW);
+			CollisionPlanes.push_back(hullFlip ? -hullplane : hullplane);
+		}
+
+		// Bevel planes for the hull edges, used when sweeping an AABB against the hull
+		hull.BevelStart = (int)CollisionPlanes.size();
+		for (int i = 0; i < hullPlanesCount; i++)
+		{
+			dvec4 plane0 = CollisionPlanes[hull.PlaneStart + i];
+			for (int j = 0; j < i; j++)
+			{
+				dvec4 plane1 = CollisionPlanes[hull.PlaneStart + j];
+				dvec4 bevelplane;
+
+				if ((plane0.x < 0.0 && plane1.x > 0.0) || (plane0.x > 0.0 && plane1.x < 0.0))
+				{
+					if (GetBevelPlane(plane0, plane1, dvec3(1.0, 0.0, 0.0), bevelplane))
+						CollisionPlanes.push_back(bevelplane);
+				}
+				if ((plane0.y < 0.0 && plane1.y > 0.0) || (plane0.y > 0.0 && plane1.y < 0.0))
+				{
+					if (GetBevelPlane(plane0, plane1, dvec3(0.0, 1.0, 0.0), bevelplane))
+						CollisionPlanes.push_back(bevelplane);
+				}
+				if ((plane0.z < 0.0 && plane1.z > 0.0) || (plane0.z > 0.0 && plane1.z < 0.0))
+				{
+					if (GetBevelPlane(plane0, plane1, dvec3(0.0, 0.0, 1.0), bevelplane))
+						CollisionPlanes.push_back(bevelplane);
+				}
+			}
+		}
+		hull.BevelCount = (int)CollisionPlanes.size() - hull.BevelStart;
+
+		node.CollisionHull = (int)CollisionHulls.size();
+		hullIndices[node.CollisionBound] = node.CollisionHull;
+		CollisionHulls.push_back(hull);
+	}
 }
 
 CollisionHitList UModel::TraceRay(const dvec3& origin, double tmin, const dvec3& dirNormalized, double tmax, bool visibilityOnly)
@@ -539,3 +819,114 @@ void UVerts::Load(ObjectStream* stream)
 
 	NumSharedSides = stream->ReadIndex();
 }
+
+/////////////////////////////////////////////////////////////////////////////
+
+ActorClassCursor::ActorClassCursor(ULevel* level, UClass* cls) : Level(level), Class(cls)
+{
+	if (!Class)
+		return;
+
+	// Merging only pays off when the lists are few and hold a small part of the level. Otherwise the level is walked like before.
+	size_t listCount = 0, actorCount = 0;
+	for (auto& it : Level->ClassActors)
+	{
+		if (!it.second.empty() && it.first->IsChildOf(Class))
+		{
+			listCount++;
+			actorCount += it.second.size();
+		}
+	}
+	WalkActors = listCount > MaxMergedLists || actorCount * 2 >= Level->Actors.size();
+
+	if (!WalkActors)
+	{
+		ActorsSize = Level->Actors.size();
+		UpdateLists();
+	}
+}
+
+void ActorClassCursor::UpdateLists()
+{
+	ListsSerial = Level->ClassActorsSerial;
+
+	// Lists already being walked keep their position. A new list belongs to a class spawned for the first time during the walk.
+	for (auto& it : Level->ClassActors)
+	{
+		if (!it.first->IsChildOf(Class) || std::find(KnownLists.begin(), KnownLists.end(), &it.second) != KnownLists.end())
+			continue;
+
+		KnownLists.push_back(&it.second);
+		ListPosition pos;
+		pos.List = &it.second;
+		Push(pos);
+	}
+}
+
+void ActorClassCursor::Push(ListPosition pos)
+{
+	const std::vector<UActor*>& list = *pos.List;
+	while (pos.Index < list.size() && !list[pos.Index])
+		pos.Index++;
+
+	if (pos.Index < list.size())
+	{
+		pos.LevelIndex = list[pos.Index]->LevelIndex;
+		Heap.push_back(pos);
+		std::push_heap(Heap.begin(), Heap.end());
+	}
+	else
+	{
+		Finished.push_back(pos);
+	}
+}
+
+UActor* ActorClassCursor::Next()
+{
+	if (!Class)
+		return nullptr;
+
+	if (WalkActors)
+	{
+		while (ActorsIndex < Level->Actors.size())
+		{
+			UActor* actor = Level->Actors[ActorsIndex++];
+			if (actor && actor->IsA(Class))
+				return actor;
+		}
+		return nullptr;
+	}
+
+	if (ListsSerial != Level->ClassActorsSerial)
+		UpdateLists();
+
+	// Spawning appends to the lists, so a list walked to the end may have grown
+	if (!Finished.empty() && ActorsSize != Level->Actors.size())
+	{
+		ActorsSize = Level->Actors.size();
+		std::vector<ListPosition> finished;
+		finished.swap(Finished);
+		for (const ListPosition& pos : finished)
+			Push(pos);
+	}
+
+	// Each list is in Actors order, so the next actor is the smallest head of the lists
+	while (!Heap.empty())
+	{
+		std::pop_heap(Heap.begin(), Heap.end());
+		ListPosition pos = Heap.back();
+		Heap.pop_back();
+
+		UActor* actor = (*pos.List)[pos.Index];
+		if (actor && actor->LevelIndex == pos.LevelIndex)
+		{
+			pos.Index++;
+			Push(pos);
+			return actor;
+		}
+
+		// Destroyed since it was pushed
+		Push(pos);
+	}
+	return nullptr;
+}
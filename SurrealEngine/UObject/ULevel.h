@@ -4,6 +4,9 @@
 #include "Math/bbox.h"
 #include "Collision/CollisionHash.h"
 #include "Collision/CollisionHit.h"
+#include "LevelPhysics.h"
+#include "ActorClassCursor.h"
+#include <unordered_map>
 
 class UTexture;
 class UActor;
@@ -45,6 +48,8 @@ public:
 	int32_t Leaf0;
 	int32_t Leaf1;
 
+	int CollisionHull = -1; // Index into UModel::CollisionHulls, built from CollisionBound at load
+
 	BBox GetCollisionBox(UModel* model) const;
 
 	UActor* ActorList = nullptr;
@@ -73,6 +78,18 @@ public:
 	int Side;
 };
 
+// Convex collision hull decoded from UModel::LeafHulls.
+// Planes and bevel planes are stored in UModel::CollisionPlanes with their normals pointing out of the hull.
+class CollisionHull
+{
+public:
+	BBox Bounds;
+	int PlaneStart = 0;
+	int PlaneCount = 0;
+	int BevelStart = 0;
+	int BevelCount = 0;
+};
+
 class ZoneProperties
 {
 public:
@@ -174,6 +191,8 @@ public:
 
 	PointRegion FindRegion(const vec3& point, UZoneInfo* levelZoneInfo);
 
+	void BuildCollisionHulls();
+
 	std::vector<vec3> Vectors;
 	std::vector<vec3> Points;
 	std::vector<BspNode> Nodes;
@@ -193,6 +212,9 @@ public:
 	std::vector<int32_t> LeafHulls;
 	std::vector<ConvexVolumeLeaf> Leaves;
 
+	std::vector<CollisionHull> CollisionHulls;
+	std::vector<dvec4> CollisionPlanes;
+
 	std::vector<UActor*> Lights;
 
 	int32_t RootOutside;
@@ -255,21 +277,49 @@ public:
 
 	void Tick(float elapsed);
 
+	void AddActor(UActor* actor);
+	void RemoveActor(UActor* actor);
+
+	// Frees the destroyed actors. No script may be running.
+	void ReleaseDestroyedActors();
+
+	// Live actors of the class or any class derived from it, in Actors order. See ActorClassCursor for a walk that doesn't copy them.
+	std::vector<UActor*> GetActorsOfClass(UClass* cls);
+
 	CollisionHit TraceFirstHit(const vec3& from, const vec3& to, UActor* tracingActor, const vec3& extents, const TraceFlags& flags);
 	CollisionHitList Trace(const vec3& from, const vec3& to, float height, float radius, bool traceActors, bool traceWorld, bool visibilityOnly);
 
 	bool TraceRayAnyHit(vec3 from, vec3 to, UActor* tracingActor, bool traceActors, bool traceWorld, bool visibilityOnly);
+	void TraceRaysAnyHit(TraceRayQuery* rays, size_t count, bool traceActors, bool traceWorld, bool visibilityOnly);
 
 	std::vector<LevelReachSpec> ReachSpecs;
 	UModel* Model = nullptr;
 
 	CollisionHash Hash;
+	LevelPhysics Physics;
 	std::vector<std::unique_ptr<LevelDecal>> Decals;
+	std::vector<UActor*> DestroyedActors; // Waiting to be released by the transient package
 
 	std::map<std::string, std::string> TravelInfo;
 
 private:
+	void BuildTickList();
+	void TickActor(UActor* actor, float elapsed);
+	void CompactActors();
+	void AddClassActor(UActor* actor);
+	void RemoveClassActor(UActor* actor);
+
 	bool ticked = false;
+	std::vector<UActor*> TickList;
+	float ReleaseCountdown = 0.0f;
+	size_t EmptyActorSlots = 0;
+
+	// Keyed by the exact class of the actor. Each list is in Actors order and destroyed actors leave a null slot until CompactActors.
+	// Lists are never erased, so a cursor can keep pointers to them.
+	std::unordered_map<UClass*, std::vector<UActor*>> ClassActors;
+	uint32_t ClassActorsSerial = 0; // Changes when a class gets its first list
+
+	friend class ActorClassCursor;
 };
 
 class ULevelSummary : public UObject
@@ -37,11 +37,7 @@ void UObject::LoadNow()
 			{
 				PropertyData.Init(static_cast<UClass*>(this));
 				if (!static_cast<UClass*>(this)->Properties.empty())
-				{
-					SetObject("Class", Class);
-					SetName("Name", Name);
-					SetInt("ObjectFlags", (int)Flags);
-				}
+					SyncNativeProperties();
 			}
 		}
 	}
@@ -69,11 +65,7 @@ void UObject::Load(ObjectStream* stream)
 		PropertyData.Init(Class);
 		PropertyData.ReadProperties(stream);
 		if (Class && !Class->Properties.empty())
-		{
-			SetObject("Class", Class);
-			SetName("Name", Name);
-			SetInt("ObjectFlags", (int)Flags);
-		}
+			SyncNativeProperties();
 	}
 }
 
@@ -244,6 +236,15 @@ void UObject::SetName(const NameString& name, const NameString& value)
 void UObject::SetObject(const NameString& name, const UObject* value)
 {
 	*static_cast<const UObject**>(GetProperty(name)) = value;
+	GC::WriteBarrier(const_cast<UObject*>(value));
+}
+
+void UObject::SyncNativeProperties(UClass* cls)
+{
+	static const NameString ClassProp("Class"), NameProp("Name"), ObjectFlagsProp("ObjectFlags");
+	SetObject(ClassProp, cls);
+	SetName(NameProp, Name);
+	SetInt(ObjectFlagsProp, (int)Flags);
 }
 
 bool UObject::IsA(const NameString& className) const
@@ -258,6 +259,11 @@ bool UObject::IsA(const NameString& className) const
 	return false;
 }
 
+bool UObject::IsA(const UClass* cls) const
+{
+	return cls && Class->IsChildOf(cls);
+}
+
 bool UObject::IsEventEnabled(const NameString& name) const
 {
 	EventName eventName = {};
@@ -332,9 +338,17 @@ NameString UObject::GetStateName() const
 	return StateFrame && StateFrame->Func ? StateFrame->Func->Name : NameString();
 }
 
+UFunction* UObject::GetEventFunction(EventName name)
+{
+	if (!EventTable)
+		EventTable = &Class->GetEventTable(GetStateName());
+	return (*EventTable)[(int)name];
+}
+
 void UObject::GotoState(NameString stateName, const NameString& labelName)
 {
-	if (stateName == "Auto")
+	static const NameString AutoState("Auto");
+	if (stateName == AutoState)
 	{
 		for (UClass* cls = Class; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
 		{
@@ -374,7 +388,10 @@ void UObject::GotoState(NameString stateName, const NameString& labelName)
 		CallEvent(this, EventName::EndState);
 
 	if (oldState != newState)
+	{
 		StateFrame->SetState(newState);
+		EventTable = &Class->GetEventTable(GetStateName());
+	}
 
 	if (newState)
 		StateFrame->GotoLabel(labelName);
@@ -425,14 +442,32 @@ void PropertyDataBlock::Reset()
 	Class = nullptr;
 }
 
+void* PropertyDataBlock::Release()
+{
+	if (Data && Class)
+	{
+		for (UProperty* prop : Class->Properties)
+			prop->Destruct(Ptr(prop));
+	}
+	void* data = Data;
+	Data = nullptr;
+	Size = 0;
+	Class = nullptr;
+	return data;
+}
+
 void PropertyDataBlock::Init(UClass* cls)
+{
+	Init(cls, new int64_t[(cls->StructSize + 7) / 8]);
+}
+
+void PropertyDataBlock::Init(UClass* cls, void* data)
 {
 	Reset();
 
 	Class = cls;
-	Size = (cls->StructSize + 7) / 8;
-	Data = new int64_t[Size];
-	Size *= 8;
+	Size = (cls->StructSize + 7) / 8 * 8;
+	Data = data;
 	for (UProperty* prop : cls->Properties)
 	{
 #ifdef _DEBUG
@@ -10,6 +10,7 @@
 class UObject;
 class UClass;
 class UProperty;
+class UFunction;
 class Package;
 class Frame;
 enum class EventName;
@@ -139,6 +140,8 @@ public:
 	~PropertyDataBlock() { Reset(); }
 
 	void Init(UClass* cls);
+	void Init(UClass* cls, void* data); // data must hold at least StructSize bytes rounded up to a multiple of 8
+	void* Release(); // Destructs the properties and hands the memory over to the caller
 	void ReadProperties(ObjectStream* stream);
 
 	void* Ptr(const UProperty* prop);
@@ -200,7 +203,12 @@ public:
 	void SetName(const NameString& name, const NameString& value);
 	void SetObject(const NameString& name, const UObject* value);
 
+	// Copies the native class, name and flags into the Class, Name and ObjectFlags properties seen by script
+	void SyncNativeProperties() { SyncNativeProperties(Class); }
+	void SyncNativeProperties(UClass* cls);
+
 	bool IsA(const NameString& className) const;
+	bool IsA(const UClass* cls) const;
 
 	bool IsEventEnabled(const NameString& name) const;
 	bool IsEventEnabled(EventName name) const;
@@ -220,6 +228,8 @@ public:
 	NameString GetStateName() const;
 	void GotoState(NameString stateName, const NameString& labelName);
 
+	UFunction* GetEventFunction(EventName name);
+
 	std::string PrintProperties();
 
 	std::map<NameString, std::set<NameString>> DisabledEvents;
@@ -232,6 +242,7 @@ public:
 
 	PropertyDataBlock PropertyData;
 	std::shared_ptr<Frame> StateFrame;
+	const std::vector<UFunction*>* EventTable = nullptr; // Event dispatch table for the current state
 
 	template<typename T>
 	T& Value(PropertyDataOffset offset) { return *static_cast<T*>(PropertyData.Ptr(offset.DataOffset)); }
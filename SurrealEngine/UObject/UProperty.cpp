@@ -241,11 +241,12 @@ void UStructProperty::Load(ObjectStream* stream)
 	if (Struct)
 		Struct->LoadNow();
 
-	if (Struct->Name == "Vector")
+	static const NameString VectorName("Vector"), RotatorName("Rotator"), ColorName("Color");
+	if (Struct->Name == VectorName)
 		ValueType = ExpressionValueType::ValueVector;
-	else if (Struct->Name == "Rotator")
+	else if (Struct->Name == RotatorName)
 		ValueType = ExpressionValueType::ValueRotator;
-	else if (Struct->Name == "Color")
+	else if (Struct->Name == ColorName)
 		ValueType = ExpressionValueType::ValueColor;
 }
 
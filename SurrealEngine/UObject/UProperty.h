@@ -1,6 +1,7 @@
 #pragma once
 
 #include "UClass.h"
+#include "GC/GC.h"
 
 struct PropertyHeader;
 
@@ -123,6 +124,18 @@ public:
 	void LoadStructMemberValue(void* data, ObjectStream* stream) override;
 	size_t Alignment() override { return sizeof(void*); }
 	size_t ElementSize() override { return sizeof(void*); }
+
+	void CopyConstruct(void* data, void* src) override
+	{
+		UObject** d = static_cast<UObject**>(data);
+		UObject** s = static_cast<UObject**>(src);
+		for (uint32_t i = 0; i < ArrayDimension; i++)
+		{
+			d[i] = s[i];
+			GC::WriteBarrier(d[i]);
+		}
+	}
+
 	std::string PrintValue(const void* data) override
 	{
 		UObject* obj = *(UObject**)data;
@@ -331,6 +344,13 @@ public:
 	size_t Alignment() override { return sizeof(void*); }
 	size_t ElementSize() override { return Struct ? Struct->StructSize : 0; }
 
+	void CopyConstruct(void* data, void* src) override
+	{
+		UProperty::CopyConstruct(data, src);
+		if (Struct)
+			GC::WriteBarrier(data, Struct, ArrayDimension);
+	}
+
 	std::string PrintValue(const void* data) override
 	{
 		if (Struct)
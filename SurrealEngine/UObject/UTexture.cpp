@@ -6,7 +6,8 @@ void UTexture::Load(ObjectStream* stream)
 {
 	UBitmap::Load(stream);
 
-	ActualFormat = (TextureFormat)GetByte("Format");
+	static const NameString FormatProp("Format"), bHasCompProp("bHasComp"), CompFormatProp("CompFormat");
+	ActualFormat = (TextureFormat)GetByte(FormatProp);
 
 	int mipsCount = stream->ReadUInt8();
 	Mipmaps.resize(mipsCount);
@@ -25,9 +26,9 @@ void UTexture::Load(ObjectStream* stream)
 		uint8_t VBits = stream->ReadUInt8();
 	}
 
-	if (HasProperty("bHasComp") && GetBool("bHasComp"))
+	if (HasProperty(bHasCompProp) && GetBool(bHasCompProp))
 	{
-		ActualFormat = (TextureFormat)GetByte("CompFormat");
+		ActualFormat = (TextureFormat)GetByte(CompFormatProp);
 
 		mipsCount = stream->ReadUInt8();
 		Mipmaps.resize(mipsCount);
@@ -85,8 +86,9 @@ void UFractalTexture::Load(ObjectStream* stream)
 	ActualFormat = TextureFormat::P8;
 	Mipmaps.resize(1);
 
-	int width = GetInt("UClamp");
-	int height = GetInt("VClamp");
+	static const NameString UClampProp("UClamp"), VClampProp("VClamp");
+	int width = GetInt(UClampProp);
+	int height = GetInt(VClampProp);
 
 	UnrealMipmap& mipmap = Mipmaps.front();
 	mipmap.Width = width;
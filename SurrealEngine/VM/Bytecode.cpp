@@ -1,8 +1,10 @@
 
 #include "Precomp.h"
 #include "Bytecode.h"
+#include "Lowering.h"
+#include "BytecodeOptimizer.h"
 
-Bytecode::Bytecode(const std::vector<uint8_t>& bytecode, Package* package)
+Bytecode::Bytecode(const std::vector<uint8_t>& bytecode, Package* package, bool optimize)
 {
 	BytecodeStream stream(bytecode.data(), bytecode.size(), package);
 	while (!stream.IsEnd())
@@ -10,6 +12,20 @@ Bytecode::Bytecode(const std::vector<uint8_t>& bytecode, Package* package)
 		Statements.push_back(ReadToken(&stream, 0));
 		Statements.back()->StatementIndex = (int)Statements.size() - 1;
 	}
+	if (optimize)
+		BytecodeOptimizer::Optimize(this);
+}
+
+Bytecode::~Bytecode()
+{
+}
+
+LoweredCode* Bytecode::GetLoweredCode()
+{
+	// Lowered on first use as the classes and properties referenced by the code may still be loading when the bytecode is parsed
+	if (!Lowered)
+		Lowered = Lowering::Lower(this);
+	return Lowered.get();
 }
 
 Expression* Bytecode::ReadToken(BytecodeStream* stream, int depth)
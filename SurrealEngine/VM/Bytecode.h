@@ -6,17 +6,25 @@
 #include "Expression.h"
 
 class BytecodeStream;
+class LoweredCode;
 
 class Bytecode
 {
 public:
-	Bytecode(const std::vector<uint8_t>& bytecode, Package* package);
+	Bytecode(const std::vector<uint8_t>& bytecode, Package* package, bool optimize = true);
+	~Bytecode();
 
 	int FindStatementIndex(uint16_t offset) const
 	{
 		return OffsetToExpression.find(offset)->second->StatementIndex;
 	}
 
+	int TryFindStatementIndex(uint16_t offset) const
+	{
+		auto it = OffsetToExpression.find(offset);
+		return it != OffsetToExpression.end() ? it->second->StatementIndex : -1;
+	}
+
 	int FindLabelIndex(const NameString& label)
 	{
 		LabelTableExpression* labels = dynamic_cast<LabelTableExpression*>(Statements.back());
@@ -31,9 +39,13 @@ public:
 		return -1;
 	}
 
+	LoweredCode* GetLoweredCode();
+
 	std::vector<Expression*> Statements;
 
 private:
+	friend class BytecodeOptimizer;
+
 	Expression* ReadToken(BytecodeStream* stream, int depth);
 
 	template<typename T>
@@ -47,6 +59,7 @@ private:
 
 	std::map<uint16_t, Expression*> OffsetToExpression;
 	std::vector<std::unique_ptr<Expression>> Allocations;
+	std::unique_ptr<LoweredCode> Lowered;
 };
 
 class BytecodeStream
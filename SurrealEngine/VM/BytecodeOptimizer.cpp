@@ -0,0 +1,352 @@
+
+#include "Precomp.h"
+#include "BytecodeOptimizer.h"
+#include "Bytecode.h"
+#include "ExpressionEvaluator.h"
+#include "NativeFunc.h"
+
+static bool GetConstant(Expression* expr, ExpressionValue& value)
+{
+	if (auto e = dynamic_cast<IntConstExpression*>(expr)) value = ExpressionValue::IntValue(e->Value);
+	else if (auto e = dynamic_cast<FloatConstExpression*>(expr)) value = ExpressionValue::FloatValue(e->Value);
+	else if (auto e = dynamic_cast<ByteConstExpression*>(expr)) value = ExpressionValue::ByteValue(e->Value);
+	else if (auto e = dynamic_cast<IntConstByteExpression*>(expr)) value = ExpressionValue::ByteValue(e->Value);
+	else if (dynamic_cast<IntZeroExpression*>(expr)) value = ExpressionValue::IntValue(0);
+	else if (dynamic_cast<IntOneExpression*>(expr)) value = ExpressionValue::IntValue(1);
+	else if (dynamic_cast<TrueExpression*>(expr)) value = ExpressionValue::BoolValue(true);
+	else if (dynamic_cast<FalseExpression*>(expr)) value = ExpressionValue::BoolValue(false);
+	else return false;
+	return true;
+}
+
+static bool IsConstant(Expression* expr)
+{
+	ExpressionValue value;
+	return GetConstant(expr, value);
+}
+
+// Expressions that pass a statement result such as Accessed None on to whatever evaluates them
+static bool ForwardsStatementResult(Expression* expr)
+{
+	return dynamic_cast<ContextExpression*>(expr) || dynamic_cast<ClassContextExpression*>(expr) || dynamic_cast<SkipExpression*>(expr) || dynamic_cast<Unknown0x2bExpression*>(expr);
+}
+
+// Native operators without side effects that can be evaluated at load time, and the type they return.
+// Only indices that no supported engine version maps to a different function are listed.
+static ExpressionValueType GetPureNativeResult(int nativeindex)
+{
+	switch (nativeindex)
+	{
+	case 129: // !bool
+	case 131: // bool ^^ bool
+	case 150: case 151: case 152: case 153: case 154: case 155: // int comparisons
+	case 176: case 177: case 178: case 179: case 180: case 181: // float comparisons
+	case 242: case 243: // bool == bool, bool != bool
+		return ExpressionValueType::ValueBool;
+	case 143: // -int
+	case 144: case 145: case 146: case 147: // int * / + -
+	case 148: case 149: // int << >>
+	case 156: case 157: case 158: // int & ^ |
+		return ExpressionValueType::ValueInt;
+	case 169: // -float
+	case 170: case 171: case 172: case 173: case 174: case 175: // float ** * / % + -
+		return ExpressionValueType::ValueFloat;
+	default:
+		return ExpressionValueType::Nothing;
+	}
+}
+
+template<typename T>
+T* BytecodeOptimizer::Create()
+{
+	// Replacement nodes are owned by the bytecode, but aren't registered in OffsetToExpression as they have no offset of their own
+	Code->Allocations.push_back(std::make_unique<T>());
+	return static_cast<T*>(Code->Allocations.back().get());
+}
+
+void BytecodeOptimizer::Optimize(Bytecode* code)
+{
+	BytecodeOptimizer optimizer;
+	optimizer.Code = code;
+
+	optimizer.StatementOffsets.resize(code->Statements.size());
+	for (auto& it : code->OffsetToExpression)
+	{
+		int index = it.second->StatementIndex;
+		if (index != -1 && code->Statements[index] == it.second)
+			optimizer.StatementOffsets[index] = it.first;
+	}
+
+	optimizer.OptimizeStatements();
+	optimizer.ThreadJumps();
+	optimizer.RemoveUnreachable();
+}
+
+void BytecodeOptimizer::OptimizeStatements()
+{
+	for (size_t i = 0; i < Code->Statements.size(); i++)
+	{
+		Expression* statement = Code->Statements[i];
+		Fold(statement);
+
+		// The value of a statement is thrown away, so there is no need to convert it to a string first.
+		// The wrapper stays if the inner expression can report Accessed None, as only statements report it.
+		if (auto eatString = dynamic_cast<EatStringExpression*>(statement))
+		{
+			if (IsConstant(eatString->Value))
+				statement = Create<NothingExpression>();
+			else if (!ForwardsStatementResult(eatString->Value))
+				statement = eatString->Value;
+		}
+
+		if (auto jumpIfNot = dynamic_cast<JumpIfNotExpression*>(statement))
+		{
+			if (dynamic_cast<TrueExpression*>(jumpIfNot->Condition))
+			{
+				statement = Create<NothingExpression>();
+			}
+			else if (dynamic_cast<FalseExpression*>(jumpIfNot->Condition))
+			{
+				JumpExpression* jump = Create<JumpExpression>();
+				jump->Offset = jumpIfNot->Offset;
+				statement = jump;
+			}
+		}
+
+		if (statement != Code->Statements[i])
+			ReplaceStatement(i, statement);
+	}
+}
+
+void BytecodeOptimizer::ThreadJumps()
+{
+	for (Expression* statement : Code->Statements)
+	{
+		if (auto jump = dynamic_cast<JumpExpression*>(statement))
+			jump->Offset = ThreadJump(jump->Offset);
+		else if (auto jumpIfNot = dynamic_cast<JumpIfNotExpression*>(statement))
+			jumpIfNot->Offset = ThreadJump(jumpIfNot->Offset);
+	}
+}
+
+uint16_t BytecodeOptimizer::ThreadJump(uint16_t offset) const
+{
+	// The step limit stops at jump cycles (an infinite loop in the script)
+	for (size_t steps = 0; steps < Code->Statements.size(); steps++)
+	{
+		int index = FindStatement(offset);
+		if (index == -1)
+			break;
+		auto jump = dynamic_cast<JumpExpression*>(Code->Statements[index]);
+		if (!jump)
+			break;
+		offset = jump->Offset;
+	}
+	return offset;
+}
+
+void BytecodeOptimizer::RemoveUnreachable()
+{
+	std::vector<Expression*>& statements = Code->Statements;
+	if (statements.empty())
+		return;
+
+	std::vector<bool> reachable(statements.size());
+	std::vector<int> queue;
+	auto add = [&](int index)
+	{
+		if (index >= 0 && index < (int)statements.size() && !reachable[index])
+		{
+			reachable[index] = true;
+			queue.push_back(index);
+		}
+	};
+
+	add(0);
+	if (auto labels = dynamic_cast<LabelTableExpression*>(statements.back()))
+	{
+		add((int)statements.size() - 1);
+		for (LabelEntry& entry : labels->Labels)
+			add(FindStatement(entry.Offset));
+	}
+
+	while (!queue.empty())
+	{
+		int index = queue.back();
+		queue.pop_back();
+
+		// Give up if a jump goes somewhere other than the start of a statement
+		Expression* statement = statements[index];
+		int target = -1;
+		if (auto jump = dynamic_cast<JumpExpression*>(statement))
+		{
+			target = FindStatement(jump->Offset);
+			if (target == -1)
+				return;
+			add(target);
+			continue;
+		}
+		else if (auto jumpIfNot = dynamic_cast<JumpIfNotExpression*>(statement))
+		{
+			target = FindStatement(jumpIfNot->Offset);
+			if (target == -1)
+				return;
+		}
+		else if (auto caseExpr = dynamic_cast<CaseExpression*>(statement))
+		{
+			if (caseExpr->Value)
+			{
+				target = FindStatement(caseExpr->NextOffset);
+				if (target == -1)
+					return;
+			}
+		}
+		else if (auto iterator = dynamic_cast<IteratorExpression*>(statement))
+		{
+			target = FindStatement(iterator->Offset);
+			if (target == -1)
+				return;
+		}
+		else if (dynamic_cast<ReturnExpression*>(statement) || dynamic_cast<StopExpression*>(statement))
+		{
+			continue;
+		}
+
+		add(target);
+		add(index + 1);
+	}
+
+	if (std::find(reachable.begin(), reachable.end(), false) == reachable.end())
+		return;
+
+	size_t count = 0;
+	for (size_t i = 0; i < statements.size(); i++)
+	{
+		if (reachable[i])
+		{
+			statements[count] = statements[i];
+			statements[count]->StatementIndex = (int)count;
+			StatementOffsets[count] = StatementOffsets[i];
+			count++;
+		}
+		else
+		{
+			Code->OffsetToExpression.erase(StatementOffsets[i]);
+			statements[i]->StatementIndex = -1;
+		}
+	}
+	statements.resize(count);
+	StatementOffsets.resize(count);
+}
+
+void BytecodeOptimizer::ReplaceStatement(size_t index, Expression* statement)
+{
+	Code->Statements[index]->StatementIndex = -1;
+	Code->Statements[index] = statement;
+	statement->StatementIndex = (int)index;
+	Code->OffsetToExpression[StatementOffsets[index]] = statement;
+}
+
+int BytecodeOptimizer::FindStatement(uint32_t offset) const
+{
+	if (offset > 0xffff)
+		return -1;
+	return Code->TryFindStatementIndex((uint16_t)offset);
+}
+
+void BytecodeOptimizer::Fold(Expression*& expr)
+{
+	if (!expr)
+		return;
+
+	Expression* oldResult = Result;
+	Result = expr;
+	expr->Visit(this);
+	expr = Result;
+	Result = oldResult;
+}
+
+void BytecodeOptimizer::FoldArgs(std::vector<Expression*>& args)
+{
+	for (Expression*& arg : args)
+		Fold(arg);
+}
+
+void BytecodeOptimizer::FoldConversion(Expression* expr, Expression*& value)
+{
+	Fold(value);
+	if (IsConstant(value))
+	{
+		// The evaluator doesn't need an object or frame for a conversion of a constant
+		Result = CreateConstant(ExpressionEvaluator::Eval(expr, nullptr, nullptr, nullptr).Value);
+	}
+}
+
+void BytecodeOptimizer::Expr(NativeFunctionExpression* expr)
+{
+	FoldArgs(expr->Args);
+
+	ExpressionValueType resultType = GetPureNativeResult(expr->nativeindex);
+	if (resultType == ExpressionValueType::Nothing || (size_t)expr->nativeindex >= NativeFunctions::NativeByIndex.size())
+		return;
+
+	const NativeFuncHandler& handler = NativeFunctions::NativeByIndex[expr->nativeindex];
+	if (!handler)
+		return;
+
+	std::vector<ExpressionValue> args(expr->Args.size() + 1);
+	for (size_t i = 0; i < expr->Args.size(); i++)
+	{
+		if (!GetConstant(expr->Args[i], args[i]))
+			return;
+	}
+
+	try
+	{
+		// Leave the things that would fail at runtime for the runtime
+		if (expr->nativeindex == 145 && args[1].ToInt() == 0)
+			return;
+		if ((expr->nativeindex == 148 || expr->nativeindex == 149) && (args[1].ToInt() < 0 || args[1].ToInt() > 31))
+			return;
+
+		ExpressionValue& result = args.back();
+		switch (resultType)
+		{
+		default:
+		case ExpressionValueType::ValueBool: result = ExpressionValue::BoolValue(false); break;
+		case ExpressionValueType::ValueInt: result = ExpressionValue::IntValue(0); break;
+		case ExpressionValueType::ValueFloat: result = ExpressionValue::FloatValue(0.0f); break;
+		}
+
+		handler(nullptr, args);
+		Result = CreateConstant(result);
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
+void BytecodeOptimizer::Expr(ByteToIntExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(ByteToBoolExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(ByteToFloatExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(IntToByteExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(IntToBoolExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(IntToFloatExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(BoolToByteExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(BoolToIntExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(BoolToFloatExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(FloatToByteExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(FloatToIntExpression* expr) { FoldConversion(expr, expr->Value); }
+void BytecodeOptimizer::Expr(FloatToBoolExpression* expr) { FoldConversion(expr, expr->Value); }
+
+Expression* BytecodeOptimizer::CreateConstant(const ExpressionValue& value)
+{
+	switch (value.GetType())
+	{
+	case ExpressionValueType::ValueByte: { auto e = Create<ByteConstExpression>(); e->Value = value.ToByte(); return e; }
+	case ExpressionValueType::ValueInt: { auto e = Create<IntConstExpression>(); e->Value = value.ToInt(); return e; }
+	case ExpressionValueType::ValueFloat: { auto e = Create<FloatConstExpression>(); e->Value = value.ToFloat(); return e; }
+	case ExpressionValueType::ValueBool: return value.ToBool() ? (Expression*)Create<TrueExpression>() : (Expression*)Create<FalseExpression>();
+	default: throw std::runtime_error("Unexpected constant type in bytecode optimizer");
+	}
+}
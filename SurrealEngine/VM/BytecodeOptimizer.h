@@ -0,0 +1,125 @@
+#pragma once
+
+#include "ExpressionVisitor.h"
+#include "Expression.h"
+
+class Bytecode;
+class ExpressionValue;
+
+// Simplifies the expression trees of a Bytecode after it has been parsed:
+// folds constant conversions and native operators, threads jumps to jumps and removes unreachable statements.
+// OffsetToExpression keeps pointing at the statements that are still there.
+class BytecodeOptimizer : ExpressionVisitor
+{
+public:
+	static void Optimize(Bytecode* code);
+
+private:
+	void OptimizeStatements();
+	void ThreadJumps();
+	void RemoveUnreachable();
+	void ReplaceStatement(size_t index, Expression* statement);
+	int FindStatement(uint32_t offset) const;
+	uint16_t ThreadJump(uint16_t offset) const;
+
+	void Fold(Expression*& expr);
+	void FoldArgs(std::vector<Expression*>& args);
+	void FoldConversion(Expression* expr, Expression*& value);
+	Expression* CreateConstant(const ExpressionValue& value);
+
+	template<typename T>
+	T* Create();
+
+	void Expr(LocalVariableExpression* expr) override { }
+	void Expr(InstanceVariableExpression* expr) override { }
+	void Expr(DefaultVariableExpression* expr) override { }
+	void Expr(ReturnExpression* expr) override { Fold(expr->Value); }
+	void Expr(SwitchExpression* expr) override { Fold(expr->Condition); }
+	void Expr(JumpExpression* expr) override { }
+	void Expr(JumpIfNotExpression* expr) override { Fold(expr->Condition); }
+	void Expr(StopExpression* expr) override { }
+	void Expr(AssertExpression* expr) override { Fold(expr->Condition); }
+	void Expr(CaseExpression* expr) override { Fold(expr->Value); }
+	void Expr(NothingExpression* expr) override { }
+	void Expr(LabelTableExpression* expr) override { }
+	void Expr(GotoLabelExpression* expr) override { Fold(expr->Value); }
+	void Expr(EatStringExpression* expr) override { Fold(expr->Value); }
+	void Expr(LetExpression* expr) override { Fold(expr->LeftSide); Fold(expr->RightSide); }
+	void Expr(DynArrayElementExpression* expr) override { Fold(expr->Index); Fold(expr->Array); }
+	void Expr(NewExpression* expr) override { Fold(expr->ParentExpr); Fold(expr->NameExpr); Fold(expr->FlagsExpr); Fold(expr->ClassExpr); }
+	void Expr(ClassContextExpression* expr) override { Fold(expr->ObjectExpr); Fold(expr->ContextExpr); }
+	void Expr(MetaCastExpression* expr) override { Fold(expr->Value); }
+	void Expr(LetBoolExpression* expr) override { Fold(expr->LeftSide); Fold(expr->RightSide); }
+	void Expr(Unknown0x15Expression* expr) override { Fold(expr->Value); }
+	void Expr(SelfExpression* expr) override { }
+	void Expr(SkipExpression* expr) override { Fold(expr->Value); }
+	void Expr(ContextExpression* expr) override { Fold(expr->ObjectExpr); Fold(expr->ContextExpr); }
+	void Expr(ArrayElementExpression* expr) override { Fold(expr->Index); Fold(expr->Array); }
+	void Expr(IntConstExpression* expr) override { }
+	void Expr(FloatConstExpression* expr) override { }
+	void Expr(StringConstExpression* expr) override { }
+	void Expr(ObjectConstExpression* expr) override { }
+	void Expr(NameConstExpression* expr) override { }
+	void Expr(RotationConstExpression* expr) override { }
+	void Expr(VectorConstExpression* expr) override { }
+	void Expr(ByteConstExpression* expr) override { }
+	void Expr(IntZeroExpression* expr) override { }
+	void Expr(IntOneExpression* expr) override { }
+	void Expr(TrueExpression* expr) override { }
+	void Expr(FalseExpression* expr) override { }
+	void Expr(NativeParmExpression* expr) override { }
+	void Expr(NoObjectExpression* expr) override { }
+	void Expr(Unknown0x2bExpression* expr) override { Fold(expr->Value); }
+	void Expr(IntConstByteExpression* expr) override { }
+	void Expr(BoolVariableExpression* expr) override { Fold(expr->Variable); }
+	void Expr(DynamicCastExpression* expr) override { Fold(expr->Value); }
+	void Expr(IteratorExpression* expr) override { Fold(expr->Value); }
+	void Expr(IteratorPopExpression* expr) override { }
+	void Expr(IteratorNextExpression* expr) override { }
+	void Expr(StructCmpEqExpression* expr) override { Fold(expr->Value1); Fold(expr->Value2); }
+	void Expr(StructCmpNeExpression* expr) override { Fold(expr->Value1); Fold(expr->Value2); }
+	void Expr(UnicodeStringConstExpression* expr) override { }
+	void Expr(StructMemberExpression* expr) override { Fold(expr->Value); }
+	void Expr(RotatorToVectorExpression* expr) override { Fold(expr->Value); }
+	void Expr(ByteToIntExpression* expr) override;
+	void Expr(ByteToBoolExpression* expr) override;
+	void Expr(ByteToFloatExpression* expr) override;
+	void Expr(IntToByteExpression* expr) override;
+	void Expr(IntToBoolExpression* expr) override;
+	void Expr(IntToFloatExpression* expr) override;
+	void Expr(BoolToByteExpression* expr) override;
+	void Expr(BoolToIntExpression* expr) override;
+	void Expr(BoolToFloatExpression* expr) override;
+	void Expr(FloatToByteExpression* expr) override;
+	void Expr(FloatToIntExpression* expr) override;
+	void Expr(FloatToBoolExpression* expr) override;
+	void Expr(Unknown0x46Expression* expr) override { Fold(expr->Value); }
+	void Expr(ObjectToBoolExpression* expr) override { Fold(expr->Value); }
+	void Expr(NameToBoolExpression* expr) override { Fold(expr->Value); }
+	void Expr(StringToByteExpression* expr) override { Fold(expr->Value); }
+	void Expr(StringToIntExpression* expr) override { Fold(expr->Value); }
+	void Expr(StringToBoolExpression* expr) override { Fold(expr->Value); }
+	void Expr(StringToFloatExpression* expr) override { Fold(expr->Value); }
+	void Expr(StringToVectorExpression* expr) override { Fold(expr->Value); }
+	void Expr(StringToRotatorExpression* expr) override { Fold(expr->Value); }
+	void Expr(VectorToBoolExpression* expr) override { Fold(expr->Value); }
+	void Expr(VectorToRotatorExpression* expr) override { Fold(expr->Value); }
+	void Expr(RotatorToBoolExpression* expr) override { Fold(expr->Value); }
+	void Expr(ByteToStringExpression* expr) override { Fold(expr->Value); }
+	void Expr(IntToStringExpression* expr) override { Fold(expr->Value); }
+	void Expr(BoolToStringExpression* expr) override { Fold(expr->Value); }
+	void Expr(FloatToStringExpression* expr) override { Fold(expr->Value); }
+	void Expr(ObjectToStringExpression* expr) override { Fold(expr->Value); }
+	void Expr(NameToStringExpression* expr) override { Fold(expr->Value); }
+	void Expr(VectorToStringExpression* expr) override { Fold(expr->Value); }
+	void Expr(RotatorToStringExpression* expr) override { Fold(expr->Value); }
+	void Expr(VirtualFunctionExpression* expr) override { FoldArgs(expr->Args); }
+	void Expr(FinalFunctionExpression* expr) override { FoldArgs(expr->Args); }
+	void Expr(GlobalFunctionExpression* expr) override { FoldArgs(expr->Args); }
+	void Expr(NativeFunctionExpression* expr) override;
+	void Expr(FunctionArgumentsExpression* expr) override { }
+
+	Bytecode* Code = nullptr;
+	std::vector<uint16_t> StatementOffsets;
+	Expression* Result = nullptr;
+};
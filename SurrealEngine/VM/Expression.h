@@ -15,6 +15,7 @@ public:
 	virtual void Visit(ExpressionVisitor* visitor) = 0;
 
 	int StatementIndex = -1;
+	bool HasBreakpoint = false; // Set by Frame::UpdateBreakpoints
 };
 
 class LocalVariableExpression : public Expression
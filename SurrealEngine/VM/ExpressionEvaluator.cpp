@@ -5,26 +5,30 @@
 #include "Bytecode.h"
 #include "Frame.h"
 #include "NativeFunc.h"
+#include "ScriptCall.h"
+#include "ScriptStack.h"
 #include "Engine.h"
 #include "Package/PackageManager.h"
 
 ExpressionEvalResult ExpressionEvaluator::Eval(Expression* expr, UObject* self, UObject* context, void* localVariables)
 {
-	auto oldExpr = Frame::StepExpression;
-	Frame::StepExpression = expr;
-
-	for (const Breakpoint& bp : Frame::Breakpoints)
-	{
-		if (bp.Expr == expr && bp.Enabled)
-		{
-			Frame::Break();
-		}
-	}
-
 	ExpressionEvaluator evaluator;
 	evaluator.Self = self;
 	evaluator.Context = context;
 	evaluator.LocalVariables = localVariables;
+
+	if (!Frame::DebuggerAttached && !expr->HasBreakpoint)
+	{
+		expr->Visit(&evaluator);
+		return std::move(evaluator.Result);
+	}
+
+	auto oldExpr = Frame::StepExpression;
+	Frame::StepExpression = expr;
+
+	if (expr->HasBreakpoint)
+		Frame::Break();
+
 	expr->Visit(&evaluator);
 	Frame::StepExpression = oldExpr;
 	return std::move(evaluator.Result);
@@ -146,14 +150,10 @@ void ExpressionEvaluator::Expr(NewExpression* expr)
 	ExpressionValue flags = Eval(expr->FlagsExpr).Value;
 	UClass* cls = UObject::Cast<UClass>(Eval(expr->ClassExpr).Value.ToObject());
 
-	// To do: package needs to be grabbed from outer, or the "transient package" if it is None, a virtual package for runtime objects
-	Package* package = engine->packages->GetPackage("Engine");
-
-	UObject* newObj = package->NewObject(
+	UObject* newObj = engine->packages->GetTransientPackage()->NewObject(
 		name.GetType() == ExpressionValueType::Nothing ? NameString() : name.ToName(),
 		cls,
-		flags.GetType() == ExpressionValueType::Nothing ? ObjectFlags::NoFlags : (ObjectFlags)flags.ToInt(),
-		true);
+		flags.GetType() == ExpressionValueType::Nothing ? ObjectFlags::NoFlags : (ObjectFlags)flags.ToInt());
 
 	if (outer.GetType() != ExpressionValueType::Nothing)
 		newObj->Outer() = outer.ToObject();
@@ -324,7 +324,7 @@ void ExpressionEvaluator::Expr(BoolVariableExpression* expr)
 void ExpressionEvaluator::Expr(DynamicCastExpression* expr)
 {
 	UObject* value = Eval(expr->Value).Value.ToObject();
-	if (value && !value->IsA(expr->Class->Name))
+	if (value && !value->IsA(expr->Class))
 		value = nullptr;
 	Result.Value = ExpressionValue::ObjectValue(value);
 }
@@ -569,43 +569,11 @@ void ExpressionEvaluator::Expr(RotatorToStringExpression* expr)
 
 void ExpressionEvaluator::Expr(VirtualFunctionExpression* expr)
 {
-	UClass* contextClass = dynamic_cast<UClass*>(Context);
-	if (!contextClass)
-		contextClass = Context->Class;
-
-	// Search states first
-
-	NameString stateName = Context->GetStateName();
-	for (UClass* cls = contextClass; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
-	{
-		UState* state = cls->GetState(stateName);
-		if (state)
-		{
-			UFunction* func = state->GetFunction(expr->Name);
-			if (func)
-			{
-				Call(func, expr->Args);
-				return;
-			}
-		}
-	}
-
-	// Search normal member functions next
-
-	for (UClass* cls = contextClass; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
-	{
-		for (UField* field = cls->Children; field != nullptr; field = field->Next)
-		{
-			UFunction* func = UObject::TryCast<UFunction>(field);
-			if (func && func->Name == expr->Name)
-			{
-				Call(func, expr->Args);
-				return;
-			}
-		}
-	}
-
-	Frame::ThrowException("Script virtual function " + expr->Name.ToString() + " not found!");
+	UFunction* func = FindVirtualFunction(Context, expr->Name);
+	if (func)
+		Call(func, expr->Args);
+	else
+		Frame::ThrowException("Script virtual function " + expr->Name.ToString() + " not found!");
 }
 
 void ExpressionEvaluator::Expr(FinalFunctionExpression* expr)
@@ -615,28 +583,20 @@ void ExpressionEvaluator::Expr(FinalFunctionExpression* expr)
 
 void ExpressionEvaluator::Expr(GlobalFunctionExpression* expr)
 {
-	// Global function calls skip the states and only searches normal member functions
-
-	UClass* contextClass = dynamic_cast<UClass*>(Context);
-	if (!contextClass)
-		contextClass = Context->Class;
-
-	for (UClass* cls = contextClass; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
-	{
-		UFunction* func = cls->GetFunction(expr->Name);
-		if (func)
-		{
-			Call(func, expr->Args);
-			return;
-		}
-	}
-
-	Frame::ThrowException("Script global function " + expr->Name.ToString() + " not found!");
+	UFunction* func = FindGlobalFunction(Context, expr->Name);
+	if (func)
+		Call(func, expr->Args);
+	else
+		Frame::ThrowException("Script global function " + expr->Name.ToString() + " not found!");
 }
 
 void ExpressionEvaluator::Expr(NativeFunctionExpression* expr)
 {
-	Call(NativeFunctions::FuncByIndex[expr->nativeindex], expr->Args);
+	UFunction* func = (size_t)expr->nativeindex < NativeFunctions::FuncByIndex.size() ? NativeFunctions::FuncByIndex[expr->nativeindex] : nullptr;
+	if (func)
+		Call(func, expr->Args);
+	else
+		Frame::ThrowException("Native function " + std::to_string(expr->nativeindex) + " not found!");
 }
 
 void ExpressionEvaluator::Call(UFunction* func, const std::vector<Expression*>& exprArgs)
@@ -651,11 +611,10 @@ void ExpressionEvaluator::Call(UFunction* func, const std::vector<Expression*>&
 	}
 	else
 	{
-		std::vector<ExpressionValue> args;
-		args.reserve(exprArgs.size());
-		for (Expression* arg : exprArgs)
-			args.push_back(Eval(arg, Self, Self, LocalVariables).Value);
-		Result.Value = Frame::Call(func, Context, std::move(args));
+		ScriptStackValues args(exprArgs.size());
+		for (size_t i = 0; i < exprArgs.size(); i++)
+			args[i] = Eval(exprArgs[i], Self, Self, LocalVariables).Value;
+		Result.Value = Frame::Call(func, Context, args.Span());
 	}
 }
 
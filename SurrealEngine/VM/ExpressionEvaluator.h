@@ -24,6 +24,7 @@ struct ExpressionEvalResult
 {
 	StatementResult Result = StatementResult::Next;
 	uint16_t JumpAddress = 0;
+	int JumpStatementIndex = -1; // JumpAddress already resolved to a statement index (lowered code only)
 	int LatentFunction = 0;
 	NameString Label;
 	ExpressionValue Value;
@@ -173,6 +173,38 @@ public:
 		return *this;
 	}
 
+	ExpressionValue& operator=(ExpressionValue&& v)
+	{
+		if (this != &v)
+		{
+			Deinit();
+
+			Type = v.Type;
+			if (!v.VariableProperty)
+			{
+				Ptr = (Type != ExpressionValueType::Nothing) ? &Buffer : nullptr;
+				switch (Type)
+				{
+				default: Buffer = v.Buffer; break;
+				case ExpressionValueType::ValueVector: new(PtrByte) vec3(std::move(*v.PtrVector)); break;
+				case ExpressionValueType::ValueRotator: new(PtrByte) Rotator(std::move(*v.PtrRotator)); break;
+				case ExpressionValueType::ValueString: new(PtrByte) std::string(std::move(*v.PtrString)); break;
+				case ExpressionValueType::ValueName: new(PtrByte) NameString(std::move(*v.PtrName)); break;
+				case ExpressionValueType::ValueColor: new(PtrByte) Color(std::move(*v.PtrColor)); break;
+				case ExpressionValueType::ValueStruct: new(PtrByte) StructValue(std::move(*v.GetStructValue())); Ptr = GetStructValue()->Ptr; break;
+				}
+			}
+			else
+			{
+				VariableProperty = v.VariableProperty;
+				Ptr = v.Ptr;
+			}
+			BoolInfo.Ptr = (uint32_t*)Ptr;
+			BoolInfo.Mask = v.BoolInfo.Mask;
+		}
+		return *this;
+	}
+
 	~ExpressionValue()
 	{
 		Deinit();
@@ -325,6 +357,26 @@ private:
 	BitfieldBool BoolInfo;
 };
 
+// Arguments for a script or native function call
+class ArgSpan
+{
+public:
+	ArgSpan() = default;
+	ArgSpan(ExpressionValue* data, size_t size) : Data(data), Size(size) {}
+	ArgSpan(std::vector<ExpressionValue>& args) : Data(args.data()), Size(args.size()) {}
+
+	// The array of an initializer list lives until the end of the full expression containing the call.
+	// Frame::Call copies the arguments before a native function gets to modify them.
+	ArgSpan(std::initializer_list<ExpressionValue> args) : Size(args.size()) { Data = const_cast<ExpressionValue*>(args.begin()); }
+
+	ExpressionValue& operator[](size_t index) const { return Data[index]; }
+	ExpressionValue* begin() const { return Data; }
+	ExpressionValue* end() const { return Data + Size; }
+
+	ExpressionValue* Data = nullptr;
+	size_t Size = 0;
+};
+
 // Pass by value
 template<> inline uint8_t ExpressionValue::ToType() { return ToByte(); }
 template<> inline int32_t ExpressionValue::ToType() { return ToInt(); }
@@ -407,7 +459,7 @@ inline void ExpressionValue::Store(const ExpressionValue& rvalue)
 	case ExpressionValueType::ValueInt: *PtrInt = rvalue.ToInt(); break;
 	case ExpressionValueType::ValueBool: BoolInfo.Set(rvalue.ToBool()); break;
 	case ExpressionValueType::ValueFloat: *PtrFloat = rvalue.ToFloat(); break;
-	case ExpressionValueType::ValueObject: *PtrObject = rvalue.ToObject(); break;
+	case ExpressionValueType::ValueObject: *PtrObject = rvalue.ToObject(); GC::WriteBarrier(*PtrObject); break;
 	case ExpressionValueType::ValueVector: *PtrVector = rvalue.ToVector(); break;
 	case ExpressionValueType::ValueRotator: *PtrRotator = rvalue.ToRotator(); break;
 	case ExpressionValueType::ValueString: *PtrString = rvalue.ToString(); break;
@@ -3,13 +3,18 @@
 #include "Frame.h"
 #include "Bytecode.h"
 #include "ExpressionEvaluator.h"
+#include "Interpreter.h"
+#include "ScriptStack.h"
+#include "ScriptProfiler.h"
 #include "NativeFunc.h"
 #include "UObject/UTextBuffer.h"
 #include "Audio/AudioSubsystem.h"
 #include "Engine.h"
 #include "Package/PackageManager.h"
+#include <algorithm>
 
 std::function<void()> Frame::RunDebugger;
+bool Frame::DebuggerAttached = false;
 std::vector<Breakpoint> Frame::Breakpoints;
 std::vector<Frame*> Frame::Callstack;
 FrameRunState Frame::RunState = FrameRunState::Running;
@@ -17,6 +22,7 @@ Frame* Frame::StepFrame = nullptr;
 Expression* Frame::StepExpression = nullptr;
 std::string Frame::ExceptionText;
 std::unique_ptr<Iterator> Frame::CreatedIterator;
+bool Frame::UseLoweredCode = true;
 
 bool Frame::AddBreakpoint(const NameString& packageName, const NameString& clsName, const NameString& funcName, const NameString& stateName)
 {
@@ -37,6 +43,7 @@ bool Frame::AddBreakpoint(const NameString& packageName, const NameString& clsNa
 				UFunction* func = static_cast<UFunction*>(child);
 				bp.Expr = func->Code->Statements.front();
 				Breakpoints.push_back(bp);
+				UpdateBreakpoints();
 				return true;
 			}
 		}
@@ -55,6 +62,7 @@ bool Frame::AddBreakpoint(const NameString& packageName, const NameString& clsNa
 						UFunction* func = static_cast<UFunction*>(child);
 						bp.Expr = func->Code->Statements.front();
 						Breakpoints.push_back(bp);
+						UpdateBreakpoints();
 						return true;
 					}
 				}
@@ -64,6 +72,36 @@ bool Frame::AddBreakpoint(const NameString& packageName, const NameString& clsNa
 	return false;
 }
 
+static std::vector<Expression*> FlaggedExpressions;
+
+void Frame::UpdateBreakpoints()
+{
+	for (Expression* expr : FlaggedExpressions)
+		expr->HasBreakpoint = false;
+	FlaggedExpressions.clear();
+
+	for (const Breakpoint& bp : Breakpoints)
+	{
+		if (bp.Expr && bp.Enabled)
+		{
+			bp.Expr->HasBreakpoint = true;
+			FlaggedExpressions.push_back(bp.Expr);
+		}
+	}
+}
+
+void Frame::RemovePackageBreakpoints(const NameString& package)
+{
+	for (Breakpoint& bp : Breakpoints)
+	{
+		if (bp.Package == package && bp.Expr)
+		{
+			FlaggedExpressions.erase(std::remove(FlaggedExpressions.begin(), FlaggedExpressions.end(), bp.Expr), FlaggedExpressions.end());
+			bp.Expr = nullptr;
+		}
+	}
+}
+
 void Frame::Break()
 {
 	RunState = FrameRunState::DebugBreak;
@@ -142,137 +180,91 @@ std::string Frame::GetCallstack()
 	return result;
 }
 
-ExpressionValue Frame::Call(UFunction* func, UObject* instance, std::vector<ExpressionValue> args)
+ExpressionValue Frame::Call(UFunction* func, UObject* instance, ArgSpan args)
 {
 	if (!instance->IsEventEnabled(func->Name))
 	{
 		return ExpressionValue::NothingValue();
 	}
 
-	int argindex = 0;
-	for (UField* field = func->Children; field != nullptr; field = field->Next)
-	{
-		UProperty* prop = dynamic_cast<UProperty*>(field);
-		if (prop)
-		{
-			if (argindex == args.size() && AllFlags(prop->PropFlags, PropertyFlags::Parm | PropertyFlags::OptionalParm))
-				args.push_back(ExpressionValue::NothingValue());
+	ScriptProfileScope profile(func, instance);
 
-			if (AllFlags(prop->PropFlags, PropertyFlags::Parm))
-				argindex++;
-		}
-	}
+	// Missing optional arguments at the end are passed as Nothing
+	size_t argcount = args.Size;
+	while (argcount < func->Parms.size() && func->Parms[argcount].OptionalParm)
+		argcount++;
 
 	if (AllFlags(func->FuncFlags, FunctionFlags::Native))
 	{
-		bool returnparmfound = false;
-		argindex = 0;
-		for (UField* field = func->Children; field != nullptr; field = field->Next)
-		{
-			UProperty* prop = dynamic_cast<UProperty*>(field);
-			if (prop)
-			{
-				if (AllFlags(prop->PropFlags, PropertyFlags::Parm | PropertyFlags::ReturnParm))
-				{
-					ExpressionValue retval = ExpressionValue::PropertyValue(prop);
-					args.push_back(std::move(retval));
-					returnparmfound = true;
-				}
-				if (AllFlags(prop->PropFlags, PropertyFlags::Parm))
-					argindex++;
-			}
-		}
+		// The native function gets its own copy of the arguments followed by the return value
+		ScriptStackValues nativeArgs(argcount + 1);
+		for (size_t i = 0; i < argcount; i++)
+			nativeArgs[i] = (i < args.Size) ? args[i] : ExpressionValue::NothingValue();
+
+		if (func->ReturnParm)
+			nativeArgs[argcount] = ExpressionValue::PropertyValue(func->ReturnParm);
 
 		try
 		{
-			if (func->NativeFuncIndex != 0)
-			{
-				auto& callback = NativeFunctions::NativeByIndex[func->NativeFuncIndex];
-				if (callback)
-				{
-					Frame frame(instance, func);
-					Callstack.push_back(&frame);
-					callback(instance, args.data());
-					Callstack.pop_back();
-				}
-				else
-				{
-					throw std::runtime_error("Unknown native function " + func->NativeStruct->Name.ToString() + "." + func->Name.ToString());
-				}
-			}
-			else
-			{
-				auto& callback = NativeFunctions::NativeByName[{ func->Name, func->NativeStruct->Name }];
-				if (callback)
-				{
-					Frame frame(instance, func);
-					Callstack.push_back(&frame);
-					callback(instance, args.data());
-					Callstack.pop_back();
-				}
-				else
-				{
-					throw std::runtime_error("Unknown native function " + func->NativeStruct->Name.ToString() + "." + func->Name.ToString());
-				}
-			}
+			if (!func->NativeHandler)
+				func->NativeHandler = NativeFunctions::FindHandler(func);
+
+			ScriptStackMemory variables(func->StructSize);
+			Frame frame(instance, func, variables.Data);
+			Callstack.push_back(&frame);
+			(*func->NativeHandler)(instance, nativeArgs.Span());
+			Callstack.pop_back();
 		}
 		catch (const std::exception& e)
 		{
 			Frame::ThrowException(e.what());
 		}
 
-		return returnparmfound ? std::move(args.back()) : ExpressionValue::NothingValue();
+		return func->ReturnParm ? std::move(nativeArgs[argcount]) : ExpressionValue::NothingValue();
 	}
 	else
 	{
-		Frame frame(instance, func);
+		ScriptStackMemory variables(func->StructSize);
+		Frame frame(instance, func, variables.Data);
 
-		int argindex = 0;
-		for (UField* field = func->Children; field != nullptr; field = field->Next)
+		for (size_t argindex = 0; argindex < func->Parms.size(); argindex++)
 		{
-			UProperty* prop = dynamic_cast<UProperty*>(field);
-			if (prop)
-			{
-				ExpressionValue lvalue = ExpressionValue::Variable(frame.Variables.get(), prop);
-				lvalue.ConstructVariable();
-				if (AllFlags(prop->PropFlags, PropertyFlags::Parm))
-				{
-					if (argindex < args.size())
-					{
-						lvalue.Store(args[argindex]);
-					}
+			ExpressionValue lvalue = ExpressionValue::Variable(frame.Variables, func->Parms[argindex].Property);
+			lvalue.ConstructVariable();
+			if (argindex < args.Size)
+				lvalue.Store(args[argindex]);
+		}
 
-					argindex++;
-				}
-			}
+		for (UProperty* prop : func->LocalVariables)
+		{
+			ExpressionValue::Variable(frame.Variables, prop).ConstructVariable();
 		}
 
 		ExpressionValue result = frame.Run().Value;
 		result.Load();
 
-		argindex = 0;
-		for (UField* field = func->Children; field != nullptr; field = field->Next)
+		for (size_t argindex = 0; argindex < func->Parms.size(); argindex++)
 		{
-			UProperty* prop = dynamic_cast<UProperty*>(field);
-			if (prop)
-			{
-				ExpressionValue lvalue = ExpressionValue::Variable(frame.Variables.get(), prop);
+			const FunctionParm& parm = func->Parms[argindex];
+			ExpressionValue lvalue = ExpressionValue::Variable(frame.Variables, parm.Property);
 
-				if (AllFlags(prop->PropFlags, PropertyFlags::Parm | PropertyFlags::OutParm) && argindex < args.size())
-				{
-					args[argindex].Store(lvalue);
-				}
+			// Out parameters are only written back to variables. Temporary values passed as arguments don't outlive the call.
+			if (parm.OutParm && argindex < args.Size && args[argindex].IsVariable())
+			{
+				args[argindex].Store(lvalue);
+			}
 
-				if (AllFlags(prop->PropFlags, PropertyFlags::ReturnParm) && result.GetType() == ExpressionValueType::Nothing)
-				{
-					result = ExpressionValue::DefaultValue(prop);
-				}
+			if (parm.ReturnParm && result.GetType() == ExpressionValueType::Nothing)
+			{
+				result = ExpressionValue::DefaultValue(parm.Property);
+			}
 
-				if (AllFlags(prop->PropFlags, PropertyFlags::Parm))
-					argindex++;
+			lvalue.DestructVariable();
+		}
 
-				lvalue.DestructVariable();
-			}
+		for (UProperty* prop : func->LocalVariables)
+		{
+			ExpressionValue::Variable(frame.Variables, prop).DestructVariable();
 		}
 
 		return result;
@@ -285,13 +277,21 @@ Frame::Frame(UObject* instance, UStruct* func)
 	SetState(func);
 }
 
+Frame::Frame(UObject* instance, UStruct* func, void* variables)
+{
+	Object = instance;
+	Func = func;
+	Variables = static_cast<uint64_t*>(variables);
+}
+
 void Frame::SetState(UStruct* func)
 {
 	Func = func;
 	if (func)
-		Variables.reset(new uint64_t[(func->StructSize + 7) / 8]);
+		VariablesStorage.reset(new uint64_t[(func->StructSize + 7) / 8]);
 	else
-		Variables.reset();
+		VariablesStorage.reset();
+	Variables = VariablesStorage.get();
 }
 
 void Frame::GotoLabel(const NameString& label)
@@ -354,7 +354,9 @@ ExpressionEvalResult Frame::Run()
 		}
 
 		Expression* statement = Func->Code->Statements[curStatementIndex];
-		ExpressionEvalResult result = ExpressionEvaluator::Eval(statement, Object, Object, Variables.get());
+		ExpressionEvalResult result = UseLoweredCode ?
+			Interpreter::Run(Func->Code.get(), curStatementIndex, Object, Variables) :
+			ExpressionEvaluator::Eval(statement, Object, Object, Variables);
 		if (!Func)
 			return result;
 		switch (result.Result)
@@ -362,7 +364,7 @@ ExpressionEvalResult Frame::Run()
 		case StatementResult::Next:
 			break;
 		case StatementResult::Jump:
-			StatementIndex = Func->Code->FindStatementIndex(result.JumpAddress);
+			StatementIndex = result.JumpStatementIndex != -1 ? result.JumpStatementIndex : Func->Code->FindStatementIndex(result.JumpAddress);
 			break;
 		case StatementResult::Switch:
 			ProcessSwitch(result.Value);
@@ -396,7 +398,7 @@ ExpressionEvalResult Frame::Run()
 				ThrowException("Iterator statement without an iterator!");
 			Iterators.push_back(std::move(result.Iter));
 			Iterators.back()->StartStatementIndex = curStatementIndex + 1;
-			Iterators.back()->EndStatementIndex = Func->Code->FindStatementIndex(result.JumpAddress);
+			Iterators.back()->EndStatementIndex = result.JumpStatementIndex != -1 ? result.JumpStatementIndex : Func->Code->FindStatementIndex(result.JumpAddress);
 			if (Iterators.back()->Next())
 				StatementIndex = Iterators.back()->StartStatementIndex;
 			else
@@ -441,7 +443,7 @@ void Frame::ProcessSwitch(const ExpressionValue& condition)
 		CaseExpression* caseexpr = static_cast<CaseExpression*>(Func->Code->Statements[StatementIndex++]);
 		if (caseexpr->Value)
 		{
-			ExpressionValue casevalue = ExpressionEvaluator::Eval(caseexpr->Value, Object, Object, Variables.get()).Value;
+			ExpressionValue casevalue = ExpressionEvaluator::Eval(caseexpr->Value, Object, Object, Variables).Value;
 			if (condition.IsEqual(casevalue))
 				break;
 			else
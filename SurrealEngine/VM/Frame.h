@@ -49,12 +49,15 @@ struct Breakpoint
 class Frame
 {
 public:
-	static ExpressionValue Call(UFunction* func, UObject* instance, std::vector<ExpressionValue> args);
+	static ExpressionValue Call(UFunction* func, UObject* instance, ArgSpan args);
 	static std::string GetCallstack();
 
 	static bool AddBreakpoint(const NameString& package, const NameString& cls, const NameString& func, const NameString& state = {});
+	static void UpdateBreakpoints(); // Must be called after Breakpoints has been modified
+	static void RemovePackageBreakpoints(const NameString& package); // Must be called before a package is unloaded, as its expressions are freed with it
 
 	static std::function<void()> RunDebugger;
+	static bool DebuggerAttached; // Track StepExpression while evaluating expressions
 	static std::vector<Breakpoint> Breakpoints;
 	static std::vector<Frame*> Callstack;
 	static FrameRunState RunState;
@@ -70,7 +73,10 @@ public:
 
 	static std::unique_ptr<Iterator> CreatedIterator;
 
+	static bool UseLoweredCode;
+
 	Frame(UObject* instance, UStruct* func);
+	Frame(UObject* instance, UStruct* func, void* variables); // For calls using the script stack for their local variables
 
 	void SetState(UStruct* func);
 
@@ -79,7 +85,7 @@ public:
 
 	LatentRunState LatentState = LatentRunState::Continue;
 
-	std::unique_ptr<uint64_t[]> Variables;
+	uint64_t* Variables = nullptr;
 	UObject* Object = nullptr;
 	UStruct* Func = nullptr;
 	size_t StatementIndex = 0;
@@ -88,4 +94,6 @@ public:
 private:
 	ExpressionEvalResult Run();
 	void ProcessSwitch(const ExpressionValue& condition);
+
+	std::unique_ptr<uint64_t[]> VariablesStorage;
 };
@@ -0,0 +1,379 @@
+
+#include "Precomp.h"
+#include "Interpreter.h"
+#include "LoweredCode.h"
+#include "Expression.h"
+#include "Bytecode.h"
+#include "Frame.h"
+#include "NativeFunc.h"
+#include "ScriptCall.h"
+#include "ScriptStack.h"
+
+static ExpressionValue CallFunction(UFunction* func, UObject* context, ExpressionValue* args, int count)
+{
+	return Frame::Call(func, context, ArgSpan(args, count));
+}
+
+// Default variables of a class object are read from the class itself, for any other object from its class
+static uint8_t* GetDefaultData(const Instruction* inst, UObject* obj)
+{
+	uintptr_t cache = inst->Cache;
+	if ((cache & ~(uintptr_t)1) != (uintptr_t)obj->Class)
+	{
+		cache = (uintptr_t)obj->Class | (dynamic_cast<UClass*>(obj) ? 1 : 0);
+		inst->Cache = cache;
+	}
+	return static_cast<uint8_t*>((cache & 1) ? obj->PropertyData.Data : obj->Class->PropertyData.Data);
+}
+
+static bool GetBool(const uint8_t* data, const Instruction* inst)
+{
+	return (*reinterpret_cast<const uint32_t*>(data) & inst->Property->DataOffset.BitfieldMask) != 0;
+}
+
+static void SetBool(uint8_t* data, const Instruction* inst, bool value)
+{
+	uint32_t& v = *reinterpret_cast<uint32_t*>(data);
+	v = value ? (v | inst->Property->DataOffset.BitfieldMask) : (v & ~inst->Property->DataOffset.BitfieldMask);
+}
+
+ExpressionEvalResult Interpreter::Run(Bytecode* code, size_t statementIndex, UObject* self, void* localVariables)
+{
+	LoweredCode* lowered = code->GetLoweredCode();
+
+	if (code->Statements[statementIndex]->HasBreakpoint)
+		Frame::Break();
+
+	ScriptStackValues registers(lowered->NumRegisters);
+	ExpressionValue* regs = registers.Values;
+
+	const Instruction* instructions = lowered->Instructions.data();
+	const Instruction* inst = instructions + lowered->StatementStart[statementIndex];
+
+	auto context = [&](const Instruction* inst) -> UObject* { return inst->A == SelfRegister ? self : regs[inst->A].ToObject(); };
+	auto local = [&](const Instruction* inst) -> uint8_t* { return static_cast<uint8_t*>(localVariables) + inst->Target; };
+	auto instance = [&](const Instruction* inst) -> uint8_t* { return static_cast<uint8_t*>(context(inst)->PropertyData.Data) + inst->Target; };
+	auto defaults = [&](const Instruction* inst) -> uint8_t* { return GetDefaultData(inst, context(inst)) + inst->Target; };
+
+	// Assigning nothing (from a None context) leaves the variable unchanged
+	auto hasValue = [&](const Instruction* inst) -> bool { return regs[inst->B].GetType() != ExpressionValueType::Nothing; };
+
+	ExpressionEvalResult result;
+	while (true)
+	{
+		switch (inst->Op)
+		{
+		case Opcode::End:
+			return result;
+
+		case Opcode::EvalStatement:
+			return ExpressionEvaluator::Eval(inst->Expr, self, self, localVariables);
+
+		case Opcode::Return:
+			result.Result = StatementResult::Return;
+			result.Value = inst->B ? regs[inst->Dest] : ExpressionValue::NothingValue();
+			return result;
+
+		case Opcode::Stop:
+			result.Result = StatementResult::Stop;
+			return result;
+
+		case Opcode::Jump:
+			result.Result = StatementResult::Jump;
+			result.JumpAddress = inst->B;
+			result.JumpStatementIndex = inst->Target;
+			return result;
+
+		case Opcode::JumpIfNot:
+			if (!regs[inst->Dest].ToBool())
+			{
+				result.Result = StatementResult::Jump;
+				result.JumpAddress = inst->B;
+				result.JumpStatementIndex = inst->Target;
+			}
+			return result;
+
+		case Opcode::Switch:
+			result.Result = StatementResult::Switch;
+			result.Value = regs[inst->Dest];
+			return result;
+
+		case Opcode::GotoLabel:
+			result.Result = StatementResult::GotoLabel;
+			result.Label = regs[inst->Dest].ToName();
+			return result;
+
+		case Opcode::Iterator:
+			result.Result = StatementResult::Iterator;
+			result.Iter = std::move(Frame::CreatedIterator);
+			result.JumpAddress = inst->B;
+			result.JumpStatementIndex = inst->Target;
+			return result;
+
+		case Opcode::IteratorNext:
+			result.Result = StatementResult::IteratorNext;
+			return result;
+
+		case Opcode::IteratorPop:
+			result.Result = StatementResult::IteratorPop;
+			return result;
+
+		case Opcode::Assert:
+			if (!regs[inst->Dest].ToBool())
+				Frame::ThrowException("Script assert failed for " + self->Name.ToString() + " line " + std::to_string(inst->B));
+			return result;
+
+		case Opcode::JumpIfFalse:
+		{
+			bool value = regs[inst->Dest].ToBool();
+			regs[inst->Dest] = ExpressionValue::BoolValue(value);
+			inst = value ? inst + 1 : instructions + inst->Target;
+			break;
+		}
+
+		case Opcode::JumpIfTrue:
+		{
+			bool value = regs[inst->Dest].ToBool();
+			regs[inst->Dest] = ExpressionValue::BoolValue(value);
+			inst = value ? instructions + inst->Target : inst + 1;
+			break;
+		}
+
+		case Opcode::ToBool:
+			regs[inst->Dest] = ExpressionValue::BoolValue(regs[inst->Dest].ToBool());
+			inst++;
+			break;
+
+		case Opcode::Eval:
+			regs[inst->Dest] = ExpressionEvaluator::Eval(inst->Expr, self, context(inst), localVariables).Value;
+			inst++;
+			break;
+
+		case Opcode::Nothing:
+			regs[inst->Dest] = ExpressionValue::NothingValue();
+			inst++;
+			break;
+
+		case Opcode::LoadConst:
+			regs[inst->Dest] = lowered->Constants[inst->Target];
+			inst++;
+			break;
+
+		case Opcode::LoadSelf:
+			regs[inst->Dest] = ExpressionValue::ObjectValue(self);
+			inst++;
+			break;
+
+		case Opcode::LoadLocal:
+			regs[inst->Dest] = ExpressionValue::Variable(localVariables, inst->Property);
+			inst++;
+			break;
+
+		case Opcode::LoadInstance:
+			regs[inst->Dest] = ExpressionValue::Variable(context(inst)->PropertyData.Data, inst->Property);
+			inst++;
+			break;
+
+		case Opcode::LoadDefault:
+			regs[inst->Dest] = ExpressionValue::Variable(GetDefaultData(inst, context(inst)), inst->Property);
+			inst++;
+			break;
+
+		case Opcode::Let:
+			regs[inst->Dest].Store(regs[inst->B]);
+			inst++;
+			break;
+
+		case Opcode::Context:
+		{
+			UObject* obj = regs[inst->A].ToObject();
+			if (obj)
+			{
+				regs[inst->A] = ExpressionValue::ObjectValue(obj);
+				inst++;
+			}
+			else
+			{
+				regs[inst->Dest] = ExpressionValue::NothingValue();
+				if (inst->B)
+					result.Result = StatementResult::AccessedNone;
+				inst = instructions + inst->Target;
+			}
+			break;
+		}
+
+		case Opcode::ClassContext:
+		{
+			UClass* cls = dynamic_cast<UClass*>(regs[inst->A].ToObject());
+			if (cls)
+			{
+				regs[inst->A] = ExpressionValue::ObjectValue(cls->GetDefaultObject());
+				inst++;
+			}
+			else
+			{
+				Frame::ThrowException("Class reference is None");
+				regs[inst->Dest] = ExpressionValue::NothingValue();
+				inst = instructions + inst->Target;
+			}
+			break;
+		}
+
+		case Opcode::ArrayElement:
+		{
+			int index = regs[inst->B].ToInt();
+			if (regs[inst->Dest].IsVariable())
+				regs[inst->Dest] = regs[inst->Dest].ItemAt(index);
+			else
+				Frame::ThrowException("Array is not a variable in ArrayElementExpression");
+			inst++;
+			break;
+		}
+
+		case Opcode::StructMember:
+		{
+			// Members of temporary struct values must be copied out before the struct goes away
+			ExpressionValue member = regs[inst->Dest].Member(inst->Property);
+			if (!regs[inst->Dest].IsVariable())
+				member.Load();
+			regs[inst->Dest] = member;
+			inst++;
+			break;
+		}
+
+		case Opcode::DynamicCast:
+		{
+			UObject* value = regs[inst->Dest].ToObject();
+			if (value && !value->IsA(inst->Class))
+				value = nullptr;
+			regs[inst->Dest] = ExpressionValue::ObjectValue(value);
+			inst++;
+			break;
+		}
+
+		case Opcode::MetaCast:
+		{
+			UObject* value = regs[inst->Dest].ToObject();
+			if (value && value != inst->Class)
+			{
+				UClass* cls = UObject::TryCast<UClass>(value);
+				while (cls)
+				{
+					if (cls == inst->Class)
+						break;
+					cls = static_cast<UClass*>(cls->BaseStruct);
+				}
+				if (!cls)
+					value = nullptr;
+			}
+			regs[inst->Dest] = ExpressionValue::ObjectValue(value);
+			inst++;
+			break;
+		}
+
+		case Opcode::StructCmpEq:
+			regs[inst->Dest] = ExpressionValue::BoolValue(regs[inst->Dest].IsEqual(regs[inst->B]));
+			inst++;
+			break;
+
+		case Opcode::StructCmpNe:
+			regs[inst->Dest] = ExpressionValue::BoolValue(!regs[inst->Dest].IsEqual(regs[inst->B]));
+			inst++;
+			break;
+
+		case Opcode::LoadLocalByte: regs[inst->Dest] = ExpressionValue::ByteValue(*local(inst)); inst++; break;
+		case Opcode::LoadLocalInt: regs[inst->Dest] = ExpressionValue::IntValue(*reinterpret_cast<int32_t*>(local(inst))); inst++; break;
+		case Opcode::LoadLocalBool: regs[inst->Dest] = ExpressionValue::BoolValue(GetBool(local(inst), inst)); inst++; break;
+		case Opcode::LoadLocalFloat: regs[inst->Dest] = ExpressionValue::FloatValue(*reinterpret_cast<float*>(local(inst))); inst++; break;
+		case Opcode::LoadLocalObject: regs[inst->Dest] = ExpressionValue::ObjectValue(*reinterpret_cast<UObject**>(local(inst))); inst++; break;
+		case Opcode::LoadLocalVector: regs[inst->Dest] = ExpressionValue::VectorValue(*reinterpret_cast<vec3*>(local(inst))); inst++; break;
+
+		case Opcode::LoadInstanceByte: regs[inst->Dest] = ExpressionValue::ByteValue(*instance(inst)); inst++; break;
+		case Opcode::LoadInstanceInt: regs[inst->Dest] = ExpressionValue::IntValue(*reinterpret_cast<int32_t*>(instance(inst))); inst++; break;
+		case Opcode::LoadInstanceBool: regs[inst->Dest] = ExpressionValue::BoolValue(GetBool(instance(inst), inst)); inst++; break;
+		case Opcode::LoadInstanceFloat: regs[inst->Dest] = ExpressionValue::FloatValue(*reinterpret_cast<float*>(instance(inst))); inst++; break;
+		case Opcode::LoadInstanceObject: regs[inst->Dest] = ExpressionValue::ObjectValue(*reinterpret_cast<UObject**>(instance(inst))); inst++; break;
+		case Opcode::LoadInstanceVector: regs[inst->Dest] = ExpressionValue::VectorValue(*reinterpret_cast<vec3*>(instance(inst))); inst++; break;
+
+		case Opcode::LoadDefaultByte: regs[inst->Dest] = ExpressionValue::ByteValue(*defaults(inst)); inst++; break;
+		case Opcode::LoadDefaultInt: regs[inst->Dest] = ExpressionValue::IntValue(*reinterpret_cast<int32_t*>(defaults(inst))); inst++; break;
+		case Opcode::LoadDefaultBool: regs[inst->Dest] = ExpressionValue::BoolValue(GetBool(defaults(inst), inst)); inst++; break;
+		case Opcode::LoadDefaultFloat: regs[inst->Dest] = ExpressionValue::FloatValue(*reinterpret_cast<float*>(defaults(inst))); inst++; break;
+		case Opcode::LoadDefaultObject: regs[inst->Dest] = ExpressionValue::ObjectValue(*reinterpret_cast<UObject**>(defaults(inst))); inst++; break;
+		case Opcode::LoadDefaultVector: regs[inst->Dest] = ExpressionValue::VectorValue(*reinterpret_cast<vec3*>(defaults(inst))); inst++; break;
+
+		case Opcode::StoreLocalByte: if (hasValue(inst)) *local(inst) = regs[inst->B].ToByte(); inst++; break;
+		case Opcode::StoreLocalInt: if (hasValue(inst)) *reinterpret_cast<int32_t*>(local(inst)) = regs[inst->B].ToInt(); inst++; break;
+		case Opcode::StoreLocalBool: if (hasValue(inst)) SetBool(local(inst), inst, regs[inst->B].ToBool()); inst++; break;
+		case Opcode::StoreLocalFloat: if (hasValue(inst)) *reinterpret_cast<float*>(local(inst)) = regs[inst->B].ToFloat(); inst++; break;
+		case Opcode::StoreLocalObject: if (hasValue(inst)) { UObject* value = regs[inst->B].ToObject(); *reinterpret_cast<UObject**>(local(inst)) = value; GC::WriteBarrier(value); } inst++; break;
+		case Opcode::StoreLocalVector: if (hasValue(inst)) *reinterpret_cast<vec3*>(local(inst)) = regs[inst->B].ToVector(); inst++; break;
+
+		case Opcode::StoreInstanceByte: if (hasValue(inst)) *instance(inst) = regs[inst->B].ToByte(); inst++; break;
+		case Opcode::StoreInstanceInt: if (hasValue(inst)) *reinterpret_cast<int32_t*>(instance(inst)) = regs[inst->B].ToInt(); inst++; break;
+		case Opcode::StoreInstanceBool: if (hasValue(inst)) SetBool(instance(inst), inst, regs[inst->B].ToBool()); inst++; break;
+		case Opcode::StoreInstanceFloat: if (hasValue(inst)) *reinterpret_cast<float*>(instance(inst)) = regs[inst->B].ToFloat(); inst++; break;
+		case Opcode::StoreInstanceObject: if (hasValue(inst)) { UObject* value = regs[inst->B].ToObject(); *reinterpret_cast<UObject**>(instance(inst)) = value; GC::WriteBarrier(value); } inst++; break;
+		case Opcode::StoreInstanceVector: if (hasValue(inst)) *reinterpret_cast<vec3*>(instance(inst)) = regs[inst->B].ToVector(); inst++; break;
+
+		case Opcode::ByteToInt: regs[inst->Dest] = ExpressionValue::IntValue(regs[inst->Dest].ToByte()); inst++; break;
+		case Opcode::ByteToBool: regs[inst->Dest] = ExpressionValue::BoolValue(regs[inst->Dest].ToByte() != 0); inst++; break;
+		case Opcode::ByteToFloat: regs[inst->Dest] = ExpressionValue::FloatValue(regs[inst->Dest].ToByte()); inst++; break;
+		case Opcode::IntToByte: regs[inst->Dest] = ExpressionValue::ByteValue(regs[inst->Dest].ToInt()); inst++; break;
+		case Opcode::IntToBool: regs[inst->Dest] = ExpressionValue::BoolValue(regs[inst->Dest].ToInt()); inst++; break;
+		case Opcode::IntToFloat: regs[inst->Dest] = ExpressionValue::FloatValue((float)regs[inst->Dest].ToInt()); inst++; break;
+		case Opcode::BoolToByte: regs[inst->Dest] = ExpressionValue::ByteValue(regs[inst->Dest].ToBool()); inst++; break;
+		case Opcode::BoolToInt: regs[inst->Dest] = ExpressionValue::IntValue(regs[inst->Dest].ToBool()); inst++; break;
+		case Opcode::BoolToFloat: regs[inst->Dest] = ExpressionValue::FloatValue(regs[inst->Dest].ToBool()); inst++; break;
+		case Opcode::FloatToByte: regs[inst->Dest] = ExpressionValue::ByteValue((int)regs[inst->Dest].ToFloat()); inst++; break;
+		case Opcode::FloatToInt: regs[inst->Dest] = ExpressionValue::IntValue((int)regs[inst->Dest].ToFloat()); inst++; break;
+		case Opcode::FloatToBool: regs[inst->Dest] = ExpressionValue::BoolValue((bool)regs[inst->Dest].ToFloat()); inst++; break;
+		case Opcode::ObjectToBool: regs[inst->Dest] = ExpressionValue::BoolValue(regs[inst->Dest].ToObject() != nullptr); inst++; break;
+
+		case Opcode::CallVirtual:
+		{
+			UObject* obj = context(inst);
+			UFunction* func = FindVirtualFunction(obj, *inst->Name);
+			if (func)
+				regs[inst->Dest] = CallFunction(func, obj, regs + inst->C, inst->B);
+			else
+				Frame::ThrowException("Script virtual function " + inst->Name->ToString() + " not found!");
+			inst++;
+			break;
+		}
+
+		case Opcode::CallFinal:
+			regs[inst->Dest] = CallFunction(inst->Func, context(inst), regs + inst->C, inst->B);
+			inst++;
+			break;
+
+		case Opcode::CallGlobal:
+		{
+			UObject* obj = context(inst);
+			UFunction* func = FindGlobalFunction(obj, *inst->Name);
+			if (func)
+				regs[inst->Dest] = CallFunction(func, obj, regs + inst->C, inst->B);
+			else
+				Frame::ThrowException("Script global function " + inst->Name->ToString() + " not found!");
+			inst++;
+			break;
+		}
+
+		case Opcode::CallNative:
+		{
+			// Lowering emits the call even when no native function has registered the index
+			UFunction* func = (size_t)inst->Target < NativeFunctions::FuncByIndex.size() ? NativeFunctions::FuncByIndex[inst->Target] : nullptr;
+			if (func)
+				regs[inst->Dest] = CallFunction(func, context(inst), regs + inst->C, inst->B);
+			else
+				Frame::ThrowException("Native function " + std::to_string(inst->Target) + " not found!");
+			inst++;
+			break;
+		}
+
+		default:
+			Frame::ThrowException("Unknown lowered opcode encountered");
+			return result;
+		}
+	}
+}
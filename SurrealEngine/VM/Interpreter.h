@@ -0,0 +1,12 @@
+#pragma once
+
+#include "ExpressionEvaluator.h"
+
+class Bytecode;
+
+// Executes statements of LoweredCode with a flat dispatch loop
+class Interpreter
+{
+public:
+	static ExpressionEvalResult Run(Bytecode* code, size_t statementIndex, UObject* self, void* localVariables);
+};
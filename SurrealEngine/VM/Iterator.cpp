@@ -8,18 +8,16 @@
 #include "UObject/UActor.h"
 #include "Collision/OverlapCylinderLevel.h"
 
-AllObjectsIterator::AllObjectsIterator(UObject* BaseClass, UObject** ReturnValue, NameString MatchTag) : BaseClass(BaseClass), ReturnValue(ReturnValue), MatchTag(MatchTag)
+AllObjectsIterator::AllObjectsIterator(UObject* BaseClass, UObject** ReturnValue, NameString MatchTag) : BaseClass(UObject::Cast<UClass>(BaseClass)), ReturnValue(ReturnValue), MatchTag(MatchTag), Cursor(engine->Level, this->BaseClass)
 {
 }
 
 bool AllObjectsIterator::Next()
 {
 	bool matchTag = !MatchTag.IsNone();
-	size_t size = engine->Level->Actors.size();
-	while (index < size)
+	while (UActor* actor = Cursor.Next())
 	{
-		UActor* actor = engine->Level->Actors[index++];
-		if (actor && actor->IsA(BaseClass->Name) && (!matchTag || actor->Tag() == MatchTag))
+		if (!matchTag || actor->Tag() == MatchTag)
 		{
 			*ReturnValue = actor;
 			return true;
@@ -61,11 +59,11 @@ bool AllFilesIterator::Next()
 
 /////////////////////////////////////////////////////////////////////////////
 
-BasedActorsIterator::BasedActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor) : BaseClass(BaseClass), Actor(Actor)
+BasedActorsIterator::BasedActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor) : BaseClass(UObject::Cast<UClass>(BaseClass)), Actor(Actor)
 {
-	for (UActor* levelActor : engine->Level->Actors)
+	for (UActor* levelActor : engine->Level->GetActorsOfClass(this->BaseClass))
 	{
-		if (levelActor->IsA(BaseClass->Name) && levelActor->IsBasedOn(Caller))
+		if (levelActor->IsBasedOn(Caller))
 			BasedActors.push_back(levelActor);
 	}
 
@@ -85,11 +83,11 @@ bool BasedActorsIterator::Next()
 
 /////////////////////////////////////////////////////////////////////////////
 
-ChildActorsIterator::ChildActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor) : BaseClass(BaseClass), Actor(Actor)
+ChildActorsIterator::ChildActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor) : BaseClass(UObject::Cast<UClass>(BaseClass)), Actor(Actor)
 {
 	for (UActor* levelActor : Caller->ChildActors)
 	{
-		if (levelActor->IsA(BaseClass->Name))
+		if (levelActor->IsA(this->BaseClass))
 			ChildActors.push_back(levelActor);
 	}
 
@@ -109,11 +107,11 @@ bool ChildActorsIterator::Next()
 
 /////////////////////////////////////////////////////////////////////////////
 
-RadiusActorsIterator::RadiusActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor, float Radius, vec3 Location) : BaseClass(BaseClass), Actor(Actor), Radius(Radius), Location(Location)
+RadiusActorsIterator::RadiusActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor, float Radius, vec3 Location) : BaseClass(UObject::Cast<UClass>(BaseClass)), Actor(Actor), Radius(Radius), Location(Location)
 {
-	for (UActor* levelActor : engine->Level->Actors)
+	for (UActor* levelActor : engine->Level->GetActorsOfClass(this->BaseClass))
 	{
-		if (levelActor->IsA(BaseClass->Name) && length(levelActor->Location() - Location) <= Radius)
+		if (length(levelActor->Location() - Location) <= Radius)
 			RadiusActors.push_back(levelActor);
 	}
 
@@ -133,7 +131,7 @@ bool RadiusActorsIterator::Next()
 
 /////////////////////////////////////////////////////////////////////////////
 
-TouchingActorsIterator::TouchingActorsIterator(UActor* Caller, UObject* BaseClass, UObject** outActor) : BaseClass(BaseClass), outActor(outActor)
+TouchingActorsIterator::TouchingActorsIterator(UActor* Caller, UObject* BaseClass, UObject** outActor) : BaseClass(UObject::Cast<UClass>(BaseClass)), outActor(outActor)
 {
 	OverlapCylinderLevel collisionTester;
 
@@ -143,7 +141,7 @@ TouchingActorsIterator::TouchingActorsIterator(UActor* Caller, UObject* BaseClas
 	for (auto& hit : hitList)
 	{
 		// Only allow the Actors of type BaseClass
-		if (hit.Actor->IsA(BaseClass->Name))
+		if (hit.Actor->IsA(this->BaseClass))
 			TouchingActors.push_back(hit.Actor);
 	}
 
@@ -163,7 +161,7 @@ bool TouchingActorsIterator::Next()
 
 /////////////////////////////////////////////////////////////////////////////
 
-TraceActorsIterator::TraceActorsIterator(UObject* BaseClass, UObject** Actor, vec3* HitLoc, vec3* HitNorm, const vec3& End, const vec3& Start, const vec3& Extent) : BaseClass(BaseClass), Actor(Actor), HitLoc(HitLoc), HitNorm(HitNorm), End(End), Start(Start), Extent(Extent)
+TraceActorsIterator::TraceActorsIterator(UObject* BaseClass, UObject** Actor, vec3* HitLoc, vec3* HitNorm, const vec3& End, const vec3& Start, const vec3& Extent) : BaseClass(UObject::Cast<UClass>(BaseClass)), Actor(Actor), HitLoc(HitLoc), HitNorm(HitNorm), End(End), Start(Start), Extent(Extent)
 {
 	UActor* BaseActor = UObject::TryCast<UActor>(BaseClass);
 
@@ -175,7 +173,7 @@ TraceActorsIterator::TraceActorsIterator(UObject* BaseClass, UObject** Actor, ve
 		if (tracedActor)
 		{
 			// Only allow the Actors of type BaseClass
-			if (tracedActor->IsA(BaseClass->Name))
+			if (tracedActor->IsA(this->BaseClass))
 				tracedActors.push_back({ tracedActor, *HitLoc, *HitNorm });
 			startPoint = *HitLoc;	// Make hit location the start point for the next trace
 			tracedActor = UObject::TryCast<UActor>(tracedActor->Trace(*HitLoc, *HitNorm, End, startPoint, true, Extent));
@@ -200,14 +198,14 @@ bool TraceActorsIterator::Next()
 
 /////////////////////////////////////////////////////////////////////////////
 
-VisibleActorsIterator::VisibleActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor, float Radius, const vec3& Location) : BaseClass(BaseClass), Actor(Actor), Radius(Radius), Location(Location)
+VisibleActorsIterator::VisibleActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor, float Radius, const vec3& Location) : BaseClass(UObject::Cast<UClass>(BaseClass)), Actor(Actor), Radius(Radius), Location(Location)
 {
-	for (auto levelActor : engine->Level->Actors)
+	for (auto levelActor : engine->Level->GetActorsOfClass(this->BaseClass))
 	{
 		// Our checks:
-		// * Whether the actor we're dealing with is not hidden and is the class of BaseClass
+		// * Whether the actor we're dealing with is not hidden
 		// * Then whether the distance of the actor from our given Location is no more than Radius
-		if (!levelActor->bHidden() && levelActor->IsA(BaseClass->Name) && 
+		if (!levelActor->bHidden() && 
 			length(levelActor->Location() - Location) <= Radius && Caller->FastTrace(levelActor->Location(), Location))
 		{
 			VisibleActors.push_back(levelActor);
@@ -230,7 +228,7 @@ bool VisibleActorsIterator::Next()
 
 /////////////////////////////////////////////////////////////////////////////
 
-VisibleCollidingActorsIterator::VisibleCollidingActorsIterator(UObject* BaseClass, UObject** ReturnValue, float Radius, const vec3& Location, bool IgnoreHidden) : BaseClass(BaseClass), ReturnValue(ReturnValue), Radius(Radius), Location(Location), IgnoreHidden(IgnoreHidden)
+VisibleCollidingActorsIterator::VisibleCollidingActorsIterator(UObject* BaseClass, UObject** ReturnValue, float Radius, const vec3& Location, bool IgnoreHidden) : BaseClass(UObject::Cast<UClass>(BaseClass)), ReturnValue(ReturnValue), Radius(Radius), Location(Location), IgnoreHidden(IgnoreHidden)
 {
 	HitActors = engine->Level->Hash.CollidingActors(Location, Radius);
 }
@@ -241,7 +239,7 @@ bool VisibleCollidingActorsIterator::Next()
 	while (index < size)
 	{
 		UActor* actor = HitActors[index++];
-		if (actor && (IgnoreHidden || !actor->bHidden()) && actor->IsA(BaseClass->Name))
+		if (actor && (IgnoreHidden || !actor->bHidden()) && actor->IsA(BaseClass))
 		{
 			*ReturnValue = actor;
 			return true;
@@ -252,17 +250,16 @@ bool VisibleCollidingActorsIterator::Next()
 
 /////////////////////////////////////////////////////////////////////////////
 
-ZoneActorsIterator::ZoneActorsIterator(UZoneInfo* zone, UObject* BaseClass, UObject** Actor) : Zone(zone), BaseClass(BaseClass), Actor(Actor)
+ZoneActorsIterator::ZoneActorsIterator(UZoneInfo* zone, UObject* BaseClass, UObject** Actor) : Zone(zone), BaseClass(UObject::Cast<UClass>(BaseClass)), Actor(Actor)
 {
 	int zoneNum = zone->BspInfo.Node->Zone1;
 
 	if (engine->Level->Model->Zones[zoneNum].ZoneActor != zone)
 		zoneNum = zone->BspInfo.Node->Zone0;
 
-	for (UActor* levelActor : engine->Level->Actors)
+	for (UActor* levelActor : engine->Level->GetActorsOfClass(this->BaseClass))
 	{
-		if ((levelActor->BspInfo.Node->Zone1 == zoneNum || levelActor->BspInfo.Node->Zone0 == zoneNum) 
-			&& levelActor->IsA(BaseClass->Name))
+		if (levelActor->BspInfo.Node->Zone1 == zoneNum || levelActor->BspInfo.Node->Zone0 == zoneNum)
 		{
 			ZoneActors.push_back(levelActor);
 		}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ExpressionValue.h"
+#include "UObject/ActorClassCursor.h"
 
 class UZoneInfo;
 class UActor;
@@ -22,10 +23,10 @@ public:
 	bool Next() override;
 
 private:
-	UObject* BaseClass = nullptr;
+	UClass* BaseClass = nullptr;
 	UObject** ReturnValue = nullptr;
 	NameString MatchTag;
-	size_t index = 0;
+	ActorClassCursor Cursor;
 };
 
 // As seen on Unreal Gold 227
@@ -50,7 +51,7 @@ public:
 	BasedActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor);
 	bool Next() override;
 
-	UObject* BaseClass = nullptr;
+	UClass* BaseClass = nullptr;
 	UObject** Actor = nullptr;
 	size_t index = 0;
 
@@ -65,7 +66,7 @@ public:
 	ChildActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor);
 	bool Next() override;
 
-	UObject* BaseClass = nullptr;
+	UClass* BaseClass = nullptr;
 	UObject** Actor = nullptr;
 	size_t index = 0;
 
@@ -79,7 +80,7 @@ public:
 	RadiusActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor, float Radius, vec3 Location);
 	bool Next() override;
 
-	UObject* BaseClass = nullptr;
+	UClass* BaseClass = nullptr;
 	UObject** Actor = nullptr;
 	float Radius = 0.0f;
 	vec3 Location;
@@ -95,7 +96,7 @@ public:
 	TouchingActorsIterator(UActor* Caller, UObject* BaseClass, UObject** outActor);
 	bool Next() override;
 
-	UObject* BaseClass = nullptr;
+	UClass* BaseClass = nullptr;
 	UObject** outActor = nullptr;
 	size_t index = 0;
 
@@ -109,7 +110,7 @@ public:
 	TraceActorsIterator(UObject* BaseClass, UObject** Actor, vec3* HitLoc, vec3* HitNorm, const vec3& End, const vec3& Start, const vec3& Extent);
 	bool Next() override;
 
-	UObject* BaseClass = nullptr;
+	UClass* BaseClass = nullptr;
 	UObject** Actor = nullptr;
 	vec3* HitLoc = nullptr;
 	vec3* HitNorm = nullptr;
@@ -135,7 +136,7 @@ public:
 	VisibleActorsIterator(UActor* Caller, UObject* BaseClass, UObject** Actor, float Radius, const vec3& Location);
 	bool Next() override;
 
-	UObject* BaseClass = nullptr;
+	UClass* BaseClass = nullptr;
 	UObject** Actor = nullptr;
 	float Radius = 0.0f;
 	vec3 Location = vec3(0.0f);
@@ -151,7 +152,7 @@ public:
 	VisibleCollidingActorsIterator(UObject* BaseClass, UObject** ReturnValue, float Radius, const vec3& Location, bool IgnoreHidden);
 	bool Next() override;
 
-	UObject* BaseClass = nullptr;
+	UClass* BaseClass = nullptr;
 	UObject** ReturnValue = nullptr;
 	float Radius = 0.0f;
 	vec3 Location = vec3(0.0f);
@@ -168,7 +169,7 @@ public:
 	bool Next() override;
 
 	UZoneInfo* Zone = nullptr;
-	UObject* BaseClass = nullptr;
+	UClass* BaseClass = nullptr;
 	UObject** Actor = nullptr;
 	size_t index = 0;
 
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "ExpressionValue.h"
+
+class Expression;
+class UProperty;
+class UFunction;
+class UClass;
+
+enum class Opcode : uint8_t
+{
+	// Statement control flow
+	End,
+	EvalStatement,
+	Return,
+	Stop,
+	Jump,
+	JumpIfNot,
+	Switch,
+	GotoLabel,
+	Iterator,
+	IteratorNext,
+	IteratorPop,
+	Assert,
+
+	// Local control flow within a statement
+	JumpIfFalse,
+	JumpIfTrue,
+	ToBool,
+
+	// Values
+	Eval,
+	Nothing,
+	LoadConst,
+	LoadSelf,
+	LoadLocal,
+	LoadInstance,
+	LoadDefault,
+	Let,
+	Context,
+	ClassContext,
+	ArrayElement,
+	StructMember,
+	DynamicCast,
+	MetaCast,
+	StructCmpEq,
+	StructCmpNe,
+
+	// Direct access to byte, int, bool, float, object and vector properties at data offset Target
+	LoadLocalByte, LoadLocalInt, LoadLocalBool, LoadLocalFloat, LoadLocalObject, LoadLocalVector,
+	LoadInstanceByte, LoadInstanceInt, LoadInstanceBool, LoadInstanceFloat, LoadInstanceObject, LoadInstanceVector,
+	LoadDefaultByte, LoadDefaultInt, LoadDefaultBool, LoadDefaultFloat, LoadDefaultObject, LoadDefaultVector,
+	StoreLocalByte, StoreLocalInt, StoreLocalBool, StoreLocalFloat, StoreLocalObject, StoreLocalVector,
+	StoreInstanceByte, StoreInstanceInt, StoreInstanceBool, StoreInstanceFloat, StoreInstanceObject, StoreInstanceVector,
+
+	// Conversions
+	ByteToInt,
+	ByteToBool,
+	ByteToFloat,
+	IntToByte,
+	IntToBool,
+	IntToFloat,
+	BoolToByte,
+	BoolToInt,
+	BoolToFloat,
+	FloatToByte,
+	FloatToInt,
+	FloatToBool,
+	ObjectToBool,
+
+	// Calls
+	CallVirtual,
+	CallFinal,
+	CallGlobal,
+	CallNative
+};
+
+// Register index used for operands that refer to the frame's own object
+static const uint16_t SelfRegister = 0xffff;
+
+struct Instruction
+{
+	Opcode Op = Opcode::End;
+	uint16_t Dest = 0;
+	uint16_t A = 0;
+	uint16_t B = 0;
+	uint16_t C = 0;
+	int32_t Target = 0; // Instruction index, statement index, constant index or native index depending on the opcode
+	union
+	{
+		void* Ptr = nullptr;
+		Expression* Expr;
+		UProperty* Property;
+		UFunction* Func;
+		UClass* Class;
+		const NameString* Name;
+	};
+
+	// Inline cache for the default variable opcodes: class of the last context object, with the low bit set if that object was itself a class
+	mutable uintptr_t Cache = 0;
+};
+
+// Linear, register based form of a function's statements. Each statement is a contiguous
+// run of instructions terminated by a statement control flow opcode (usually End).
+class LoweredCode
+{
+public:
+	std::vector<Instruction> Instructions;
+	std::vector<int> StatementStart;
+	std::vector<ExpressionValue> Constants;
+	int NumRegisters = 0;
+};
@@ -0,0 +1,530 @@
+
+#include "Precomp.h"
+#include "Lowering.h"
+#include "Expression.h"
+#include "Bytecode.h"
+#include "NativeFunc.h"
+
+static bool IsTypedProperty(UProperty* prop)
+{
+	return prop->ValueType >= ExpressionValueType::ValueByte && prop->ValueType <= ExpressionValueType::ValueVector && prop->ArrayDimension == 1;
+}
+
+static Opcode GetTypedOpcode(Opcode byteOp, UProperty* prop)
+{
+	return (Opcode)((int)byteOp + (int)prop->ValueType - (int)ExpressionValueType::ValueByte);
+}
+
+std::unique_ptr<LoweredCode> Lowering::Lower(Bytecode* code)
+{
+	auto lowered = std::make_unique<LoweredCode>();
+	Lowering lowering;
+	lowering.Source = code;
+	lowering.Code = lowered.get();
+	for (Expression* statement : code->Statements)
+		lowering.LowerStatement(statement);
+	return lowered;
+}
+
+void Lowering::LowerStatement(Expression* statement)
+{
+	Code->StatementStart.push_back(GetPosition());
+	Compile(statement, 0, SelfRegister, 1, true);
+	Emit(Opcode::End);
+}
+
+void Lowering::Compile(Expression* expr, int dest, int ctx, int temp, bool root, bool valueOnly)
+{
+	if (temp >= (int)SelfRegister)
+		throw std::runtime_error("Script statement needs too many registers");
+
+	Code->NumRegisters = std::max(Code->NumRegisters, std::max(dest + 1, temp));
+
+	Expression* oldExpr = CurExpr;
+	int oldDest = Dest, oldCtx = Ctx, oldTemp = Temp;
+	bool oldRoot = Root, oldValueOnly = ValueOnly;
+
+	CurExpr = expr;
+	Dest = dest;
+	Ctx = ctx;
+	Temp = temp;
+	Root = root;
+	ValueOnly = valueOnly;
+
+	expr->Visit(this);
+
+	CurExpr = oldExpr;
+	Dest = oldDest;
+	Ctx = oldCtx;
+	Temp = oldTemp;
+	Root = oldRoot;
+	ValueOnly = oldValueOnly;
+}
+
+void Lowering::CompileValue(Expression* expr, int dest, int ctx, int temp)
+{
+	Compile(expr, dest, ctx, temp, false, true);
+}
+
+Instruction& Lowering::Emit(Opcode op)
+{
+	Code->Instructions.push_back({});
+	Instruction& inst = Code->Instructions.back();
+	inst.Op = op;
+	inst.Dest = (uint16_t)Dest;
+	inst.A = (uint16_t)Ctx;
+	return inst;
+}
+
+void Lowering::Fallback()
+{
+	// Statement results (jumps, iterators and so on) are only kept for the root expression
+	if (Root)
+		Emit(Opcode::EvalStatement).Expr = CurExpr;
+	else
+		Emit(Opcode::Eval).Expr = CurExpr;
+}
+
+int Lowering::JumpTarget(uint16_t offset)
+{
+	return Source->TryFindStatementIndex(offset);
+}
+
+void Lowering::CompileConst(ExpressionValue value)
+{
+	Code->Constants.push_back(std::move(value));
+	Emit(Opcode::LoadConst).Target = (int32_t)Code->Constants.size() - 1;
+}
+
+void Lowering::CompileUnary(Opcode op, Expression* value)
+{
+	CompileValue(value, Dest, Ctx, Temp);
+	Emit(op);
+}
+
+void Lowering::CompileCall(Opcode op, const std::vector<Expression*>& args, UFunction* func)
+{
+	// Arguments are always evaluated in the context of the calling object.
+	// Only out parameters need a reference to the variable when the function is known.
+	int first = Temp;
+	for (size_t i = 0; i < args.size(); i++)
+	{
+		bool valueOnly = func && i < func->Parms.size() && !func->Parms[i].OutParm && !func->Parms[i].ReturnParm;
+		Compile(args[i], first + (int)i, SelfRegister, first + (int)i + 1, false, valueOnly);
+	}
+
+	Instruction& inst = Emit(op);
+	inst.B = (uint16_t)args.size();
+	inst.C = (uint16_t)first;
+}
+
+void Lowering::CompileVariable(Opcode op, Opcode typedOp, UProperty* prop)
+{
+	if (ValueOnly && IsTypedProperty(prop))
+	{
+		Instruction& inst = Emit(GetTypedOpcode(typedOp, prop));
+		inst.Property = prop;
+		inst.Target = prop->DataOffset.DataOffset;
+	}
+	else
+	{
+		Emit(op).Property = prop;
+	}
+}
+
+bool Lowering::CompileStore(Expression* lvalue, Expression* rvalue)
+{
+	if (auto boolVar = dynamic_cast<BoolVariableExpression*>(lvalue))
+		lvalue = boolVar->Variable;
+
+	Opcode op;
+	UProperty* prop;
+	if (auto local = dynamic_cast<LocalVariableExpression*>(lvalue))
+	{
+		op = Opcode::StoreLocalByte;
+		prop = local->Variable;
+	}
+	else if (auto instance = dynamic_cast<InstanceVariableExpression*>(lvalue))
+	{
+		op = Opcode::StoreInstanceByte;
+		prop = instance->Variable;
+	}
+	else
+	{
+		return false;
+	}
+
+	if (!IsTypedProperty(prop))
+		return false;
+
+	CompileValue(rvalue, Temp, Ctx, Temp + 1);
+	Instruction& inst = Emit(GetTypedOpcode(op, prop));
+	inst.B = (uint16_t)Temp;
+	inst.Property = prop;
+	inst.Target = prop->DataOffset.DataOffset;
+	return true;
+}
+
+void Lowering::Expr(LocalVariableExpression* expr)
+{
+	CompileVariable(Opcode::LoadLocal, Opcode::LoadLocalByte, expr->Variable);
+}
+
+void Lowering::Expr(InstanceVariableExpression* expr)
+{
+	CompileVariable(Opcode::LoadInstance, Opcode::LoadInstanceByte, expr->Variable);
+}
+
+void Lowering::Expr(DefaultVariableExpression* expr)
+{
+	CompileVariable(Opcode::LoadDefault, Opcode::LoadDefaultByte, expr->Variable);
+}
+
+void Lowering::Expr(ReturnExpression* expr)
+{
+	if (!Root)
+		return Fallback();
+
+	if (expr->Value)
+		CompileValue(expr->Value, Dest, Ctx, Temp);
+	Emit(Opcode::Return).B = expr->Value ? 1 : 0;
+}
+
+void Lowering::Expr(SwitchExpression* expr)
+{
+	if (!Root)
+		return Fallback();
+
+	CompileValue(expr->Condition, Dest, Ctx, Temp);
+	Emit(Opcode::Switch);
+}
+
+void Lowering::Expr(JumpExpression* expr)
+{
+	int target = JumpTarget(expr->Offset);
+	if (!Root || target == -1)
+		return Fallback();
+
+	Instruction& inst = Emit(Opcode::Jump);
+	inst.B = expr->Offset;
+	inst.Target = target;
+}
+
+void Lowering::Expr(JumpIfNotExpression* expr)
+{
+	int target = JumpTarget(expr->Offset);
+	if (!Root || target == -1)
+		return Fallback();
+
+	CompileValue(expr->Condition, Dest, Ctx, Temp);
+	Instruction& inst = Emit(Opcode::JumpIfNot);
+	inst.B = expr->Offset;
+	inst.Target = target;
+}
+
+void Lowering::Expr(StopExpression* expr)
+{
+	if (!Root)
+		return Fallback();
+
+	Emit(Opcode::Stop);
+}
+
+void Lowering::Expr(AssertExpression* expr)
+{
+	if (!Root)
+		return Fallback();
+
+	CompileValue(expr->Condition, Dest, Ctx, Temp);
+	Emit(Opcode::Assert).B = expr->Line;
+}
+
+void Lowering::Expr(CaseExpression* expr)
+{
+	// Case values are evaluated by Frame::ProcessSwitch. Falling into a case label does nothing.
+	Emit(Opcode::Nothing);
+}
+
+void Lowering::Expr(NothingExpression* expr)
+{
+	Emit(Opcode::Nothing);
+}
+
+void Lowering::Expr(GotoLabelExpression* expr)
+{
+	if (!Root)
+		return Fallback();
+
+	CompileValue(expr->Value, Dest, Ctx, Temp);
+	Emit(Opcode::GotoLabel);
+}
+
+void Lowering::Expr(EatStringExpression* expr)
+{
+	Compile(expr->Value, Dest, Ctx, Temp);
+	Emit(Opcode::Nothing);
+}
+
+void Lowering::Expr(LetExpression* expr)
+{
+	// The result of an assignment is only used when it isn't a statement by itself
+	if (Root && CompileStore(expr->LeftSide, expr->RightSide))
+		return;
+
+	Compile(expr->LeftSide, Dest, Ctx, Temp);
+	CompileValue(expr->RightSide, Temp, Ctx, Temp + 1);
+	Emit(Opcode::Let).B = (uint16_t)Temp;
+}
+
+void Lowering::Expr(LetBoolExpression* expr)
+{
+	if (Root && CompileStore(expr->LeftSide, expr->RightSide))
+		return;
+
+	Compile(expr->LeftSide, Dest, Ctx, Temp);
+	CompileValue(expr->RightSide, Temp, Ctx, Temp + 1);
+	Emit(Opcode::Let).B = (uint16_t)Temp;
+}
+
+void Lowering::Expr(ClassContextExpression* expr)
+{
+	int objectRegister = Temp;
+	CompileValue(expr->ObjectExpr, objectRegister, Ctx, objectRegister + 1);
+	int contextInst = GetPosition();
+	Emit(Opcode::ClassContext).A = (uint16_t)objectRegister;
+	Compile(expr->ContextExpr, Dest, objectRegister, objectRegister + 1, false, ValueOnly);
+	Code->Instructions[contextInst].Target = GetPosition();
+}
+
+void Lowering::Expr(ContextExpression* expr)
+{
+	int objectRegister = Temp;
+	CompileValue(expr->ObjectExpr, objectRegister, Ctx, objectRegister + 1);
+	int contextInst = GetPosition();
+	Instruction& inst = Emit(Opcode::Context);
+	inst.A = (uint16_t)objectRegister;
+	inst.B = Root ? 1 : 0;
+	Compile(expr->ContextExpr, Dest, objectRegister, objectRegister + 1, false, ValueOnly);
+	Code->Instructions[contextInst].Target = GetPosition();
+}
+
+void Lowering::Expr(MetaCastExpression* expr)
+{
+	CompileValue(expr->Value, Dest, Ctx, Temp);
+	Emit(Opcode::MetaCast).Class = expr->Class;
+}
+
+void Lowering::Expr(SelfExpression* expr)
+{
+	Emit(Opcode::LoadSelf);
+}
+
+void Lowering::Expr(SkipExpression* expr)
+{
+	Compile(expr->Value, Dest, Ctx, Temp, Root, ValueOnly);
+}
+
+void Lowering::Expr(ArrayElementExpression* expr)
+{
+	CompileValue(expr->Index, Temp, Ctx, Temp + 1);
+	Compile(expr->Array, Dest, Ctx, Temp + 1);
+	Emit(Opcode::ArrayElement).B = (uint16_t)Temp;
+}
+
+void Lowering::Expr(IntConstExpression* expr)
+{
+	CompileConst(ExpressionValue::IntValue(expr->Value));
+}
+
+void Lowering::Expr(FloatConstExpression* expr)
+{
+	CompileConst(ExpressionValue::FloatValue(expr->Value));
+}
+
+void Lowering::Expr(StringConstExpression* expr)
+{
+	CompileConst(ExpressionValue::StringValue(expr->Value));
+}
+
+void Lowering::Expr(ObjectConstExpression* expr)
+{
+	CompileConst(ExpressionValue::ObjectValue(expr->Object));
+}
+
+void Lowering::Expr(NameConstExpression* expr)
+{
+	CompileConst(ExpressionValue::NameValue(expr->Value));
+}
+
+void Lowering::Expr(RotationConstExpression* expr)
+{
+	CompileConst(ExpressionValue::RotatorValue({ expr->Pitch, expr->Yaw, expr->Roll }));
+}
+
+void Lowering::Expr(VectorConstExpression* expr)
+{
+	CompileConst(ExpressionValue::VectorValue({ expr->X, expr->Y, expr->Z }));
+}
+
+void Lowering::Expr(ByteConstExpression* expr)
+{
+	CompileConst(ExpressionValue::ByteValue(expr->Value));
+}
+
+void Lowering::Expr(IntZeroExpression* expr)
+{
+	CompileConst(ExpressionValue::IntValue(0));
+}
+
+void Lowering::Expr(IntOneExpression* expr)
+{
+	CompileConst(ExpressionValue::IntValue(1));
+}
+
+void Lowering::Expr(TrueExpression* expr)
+{
+	CompileConst(ExpressionValue::BoolValue(true));
+}
+
+void Lowering::Expr(FalseExpression* expr)
+{
+	CompileConst(ExpressionValue::BoolValue(false));
+}
+
+void Lowering::Expr(NoObjectExpression* expr)
+{
+	CompileConst(ExpressionValue::ObjectValue(nullptr));
+}
+
+void Lowering::Expr(Unknown0x2bExpression* expr)
+{
+	Compile(expr->Value, Dest, Ctx, Temp, Root, ValueOnly);
+}
+
+void Lowering::Expr(IntConstByteExpression* expr)
+{
+	CompileConst(ExpressionValue::ByteValue(expr->Value));
+}
+
+void Lowering::Expr(BoolVariableExpression* expr)
+{
+	Compile(expr->Variable, Dest, Ctx, Temp, false, ValueOnly);
+}
+
+void Lowering::Expr(DynamicCastExpression* expr)
+{
+	CompileValue(expr->Value, Dest, Ctx, Temp);
+	Emit(Opcode::DynamicCast).Class = expr->Class;
+}
+
+void Lowering::Expr(IteratorExpression* expr)
+{
+	int target = JumpTarget(expr->Offset);
+	if (!Root || target == -1)
+		return Fallback();
+
+	Compile(expr->Value, Dest, Ctx, Temp);
+	Instruction& inst = Emit(Opcode::Iterator);
+	inst.B = expr->Offset;
+	inst.Target = target;
+}
+
+void Lowering::Expr(IteratorPopExpression* expr)
+{
+	if (!Root)
+		return Fallback();
+
+	Emit(Opcode::IteratorPop);
+}
+
+void Lowering::Expr(IteratorNextExpression* expr)
+{
+	if (!Root)
+		return Fallback();
+
+	Emit(Opcode::IteratorNext);
+}
+
+void Lowering::Expr(StructCmpEqExpression* expr)
+{
+	Compile(expr->Value1, Dest, Ctx, Temp);
+	Compile(expr->Value2, Temp, Ctx, Temp + 1);
+	Emit(Opcode::StructCmpEq).B = (uint16_t)Temp;
+}
+
+void Lowering::Expr(StructCmpNeExpression* expr)
+{
+	Compile(expr->Value1, Dest, Ctx, Temp);
+	Compile(expr->Value2, Temp, Ctx, Temp + 1);
+	Emit(Opcode::StructCmpNe).B = (uint16_t)Temp;
+}
+
+void Lowering::Expr(UnicodeStringConstExpression* expr)
+{
+	std::string s;
+	s.reserve(expr->Value.size());
+	for (wchar_t c : expr->Value)
+		s.push_back(c < 128 ? c : '?');
+	CompileConst(ExpressionValue::StringValue(s));
+}
+
+void Lowering::Expr(StructMemberExpression* expr)
+{
+	if (!expr->Field)
+		return Fallback();
+
+	Compile(expr->Value, Dest, Ctx, Temp);
+	Emit(Opcode::StructMember).Property = expr->Field;
+}
+
+void Lowering::Expr(ByteToIntExpression* expr) { CompileUnary(Opcode::ByteToInt, expr->Value); }
+void Lowering::Expr(ByteToBoolExpression* expr) { CompileUnary(Opcode::ByteToBool, expr->Value); }
+void Lowering::Expr(ByteToFloatExpression* expr) { CompileUnary(Opcode::ByteToFloat, expr->Value); }
+void Lowering::Expr(IntToByteExpression* expr) { CompileUnary(Opcode::IntToByte, expr->Value); }
+void Lowering::Expr(IntToBoolExpression* expr) { CompileUnary(Opcode::IntToBool, expr->Value); }
+void Lowering::Expr(IntToFloatExpression* expr) { CompileUnary(Opcode::IntToFloat, expr->Value); }
+void Lowering::Expr(BoolToByteExpression* expr) { CompileUnary(Opcode::BoolToByte, expr->Value); }
+void Lowering::Expr(BoolToIntExpression* expr) { CompileUnary(Opcode::BoolToInt, expr->Value); }
+void Lowering::Expr(BoolToFloatExpression* expr) { CompileUnary(Opcode::BoolToFloat, expr->Value); }
+void Lowering::Expr(FloatToByteExpression* expr) { CompileUnary(Opcode::FloatToByte, expr->Value); }
+void Lowering::Expr(FloatToIntExpression* expr) { CompileUnary(Opcode::FloatToInt, expr->Value); }
+void Lowering::Expr(FloatToBoolExpression* expr) { CompileUnary(Opcode::FloatToBool, expr->Value); }
+void Lowering::Expr(ObjectToBoolExpression* expr) { CompileUnary(Opcode::ObjectToBool, expr->Value); }
+
+void Lowering::Expr(VirtualFunctionExpression* expr)
+{
+	CompileCall(Opcode::CallVirtual, expr->Args);
+	Code->Instructions.back().Name = &expr->Name;
+}
+
+void Lowering::Expr(FinalFunctionExpression* expr)
+{
+	CompileCall(Opcode::CallFinal, expr->Args, expr->Func);
+	Code->Instructions.back().Func = expr->Func;
+}
+
+void Lowering::Expr(GlobalFunctionExpression* expr)
+{
+	CompileCall(Opcode::CallGlobal, expr->Args);
+	Code->Instructions.back().Name = &expr->Name;
+}
+
+void Lowering::Expr(NativeFunctionExpression* expr)
+{
+	// The && and || operators must short-circuit
+	if ((expr->nativeindex == 130 || expr->nativeindex == 132) && expr->Args.size() == 2)
+	{
+		CompileValue(expr->Args[0], Dest, SelfRegister, Temp);
+		int jumpInst = GetPosition();
+		Emit(expr->nativeindex == 130 ? Opcode::JumpIfFalse : Opcode::JumpIfTrue);
+		CompileValue(expr->Args[1], Dest, SelfRegister, Temp);
+		Emit(Opcode::ToBool);
+		Code->Instructions[jumpInst].Target = GetPosition();
+	}
+	else
+	{
+		UFunction* func = (size_t)expr->nativeindex < NativeFunctions::FuncByIndex.size() ? NativeFunctions::FuncByIndex[expr->nativeindex] : nullptr;
+		CompileCall(Opcode::CallNative, expr->Args, func);
+		Code->Instructions.back().Target = expr->nativeindex;
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "ExpressionVisitor.h"
+#include "LoweredCode.h"
+
+class Bytecode;
+
+// Compiles the expression trees of a Bytecode into LoweredCode.
+// Nodes without a dedicated opcode are compiled to Eval instructions that fall back to the ExpressionEvaluator.
+class Lowering : ExpressionVisitor
+{
+public:
+	static std::unique_ptr<LoweredCode> Lower(Bytecode* code);
+
+private:
+	void LowerStatement(Expression* statement);
+	void Compile(Expression* expr, int dest, int ctx, int temp, bool root = false, bool valueOnly = false);
+	void CompileValue(Expression* expr, int dest, int ctx, int temp);
+	void CompileVariable(Opcode op, Opcode typedOp, UProperty* prop);
+	bool CompileStore(Expression* lvalue, Expression* rvalue);
+	void CompileCall(Opcode op, const std::vector<Expression*>& args, UFunction* func = nullptr);
+	void CompileConst(ExpressionValue value);
+	void CompileUnary(Opcode op, Expression* value);
+	void Fallback();
+	int JumpTarget(uint16_t offset);
+
+	Instruction& Emit(Opcode op);
+	int GetPosition() const { return (int)Code->Instructions.size(); }
+
+	void Expr(LocalVariableExpression* expr) override;
+	void Expr(InstanceVariableExpression* expr) override;
+	void Expr(DefaultVariableExpression* expr) override;
+	void Expr(ReturnExpression* expr) override;
+	void Expr(SwitchExpression* expr) override;
+	void Expr(JumpExpression* expr) override;
+	void Expr(JumpIfNotExpression* expr) override;
+	void Expr(StopExpression* expr) override;
+	void Expr(AssertExpression* expr) override;
+	void Expr(CaseExpression* expr) override;
+	void Expr(NothingExpression* expr) override;
+	void Expr(LabelTableExpression* expr) override { Fallback(); }
+	void Expr(GotoLabelExpression* expr) override;
+	void Expr(EatStringExpression* expr) override;
+	void Expr(LetExpression* expr) override;
+	void Expr(DynArrayElementExpression* expr) override { Fallback(); }
+	void Expr(NewExpression* expr) override { Fallback(); }
+	void Expr(ClassContextExpression* expr) override;
+	void Expr(MetaCastExpression* expr) override;
+	void Expr(LetBoolExpression* expr) override;
+	void Expr(Unknown0x15Expression* expr) override { Fallback(); }
+	void Expr(SelfExpression* expr) override;
+	void Expr(SkipExpression* expr) override;
+	void Expr(ContextExpression* expr) override;
+	void Expr(ArrayElementExpression* expr) override;
+	void Expr(IntConstExpression* expr) override;
+	void Expr(FloatConstExpression* expr) override;
+	void Expr(StringConstExpression* expr) override;
+	void Expr(ObjectConstExpression* expr) override;
+	void Expr(NameConstExpression* expr) override;
+	void Expr(RotationConstExpression* expr) override;
+	void Expr(VectorConstExpression* expr) override;
+	void Expr(ByteConstExpression* expr) override;
+	void Expr(IntZeroExpression* expr) override;
+	void Expr(IntOneExpression* expr) override;
+	void Expr(TrueExpression* expr) override;
+	void Expr(FalseExpression* expr) override;
+	void Expr(NativeParmExpression* expr) override { Fallback(); }
+	void Expr(NoObjectExpression* expr) override;
+	void Expr(Unknown0x2bExpression* expr) override;
+	void Expr(IntConstByteExpression* expr) override;
+	void Expr(BoolVariableExpression* expr) override;
+	void Expr(DynamicCastExpression* expr) override;
+	void Expr(IteratorExpression* expr) override;
+	void Expr(IteratorPopExpression* expr) override;
+	void Expr(IteratorNextExpression* expr) override;
+	void Expr(StructCmpEqExpression* expr) override;
+	void Expr(StructCmpNeExpression* expr) override;
+	void Expr(UnicodeStringConstExpression* expr) override;
+	void Expr(StructMemberExpression* expr) override;
+	void Expr(RotatorToVectorExpression* expr) override { Fallback(); }
+	void Expr(ByteToIntExpression* expr) override;
+	void Expr(ByteToBoolExpression* expr) override;
+	void Expr(ByteToFloatExpression* expr) override;
+	void Expr(IntToByteExpression* expr) override;
+	void Expr(IntToBoolExpression* expr) override;
+	void Expr(IntToFloatExpression* expr) override;
+	void Expr(BoolToByteExpression* expr) override;
+	void Expr(BoolToIntExpression* expr) override;
+	void Expr(BoolToFloatExpression* expr) override;
+	void Expr(FloatToByteExpression* expr) override;
+	void Expr(FloatToIntExpression* expr) override;
+	void Expr(FloatToBoolExpression* expr) override;
+	void Expr(Unknown0x46Expression* expr) override { Fallback(); }
+	void Expr(ObjectToBoolExpression* expr) override;
+	void Expr(NameToBoolExpression* expr) override { Fallback(); }
+	void Expr(StringToByteExpression* expr) override { Fallback(); }
+	void Expr(StringToIntExpression* expr) override { Fallback(); }
+	void Expr(StringToBoolExpression* expr) override { Fallback(); }
+	void Expr(StringToFloatExpression* expr) override { Fallback(); }
+	void Expr(StringToVectorExpression* expr) override { Fallback(); }
+	void Expr(StringToRotatorExpression* expr) override { Fallback(); }
+	void Expr(VectorToBoolExpression* expr) override { Fallback(); }
+	void Expr(VectorToRotatorExpression* expr) override { Fallback(); }
+	void Expr(RotatorToBoolExpression* expr) override { Fallback(); }
+	void Expr(ByteToStringExpression* expr) override { Fallback(); }
+	void Expr(IntToStringExpression* expr) override { Fallback(); }
+	void Expr(BoolToStringExpression* expr) override { Fallback(); }
+	void Expr(FloatToStringExpression* expr) override { Fallback(); }
+	void Expr(ObjectToStringExpression* expr) override { Fallback(); }
+	void Expr(NameToStringExpression* expr) override { Fallback(); }
+	void Expr(VectorToStringExpression* expr) override { Fallback(); }
+	void Expr(RotatorToStringExpression* expr) override { Fallback(); }
+	void Expr(VirtualFunctionExpression* expr) override;
+	void Expr(FinalFunctionExpression* expr) override;
+	void Expr(GlobalFunctionExpression* expr) override;
+	void Expr(NativeFunctionExpression* expr) override;
+	void Expr(FunctionArgumentsExpression* expr) override { Fallback(); }
+
+	Bytecode* Source = nullptr;
+	LoweredCode* Code = nullptr;
+
+	// Destination register, context object register and first free register for the expression being compiled
+	Expression* CurExpr = nullptr;
+	int Dest = 0;
+	int Ctx = SelfRegister;
+	int Temp = 1;
+	bool Root = false;
+
+	// Set when only the value of the expression is needed, not a reference to the variable holding it
+	bool ValueOnly = false;
+};
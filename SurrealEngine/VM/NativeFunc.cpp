@@ -28,3 +28,19 @@ void NativeFunctions::RegisterNativeFunc(UFunction* func)
 		FuncByIndex[nativeIndex] = func;
 	}
 }
+
+const NativeFuncHandler* NativeFunctions::FindHandler(UFunction* func)
+{
+	if (func->NativeFuncIndex != 0)
+	{
+		if ((size_t)func->NativeFuncIndex < NativeByIndex.size() && NativeByIndex[func->NativeFuncIndex])
+			return &NativeByIndex[func->NativeFuncIndex];
+	}
+	else
+	{
+		auto it = NativeByName.find({ func->Name, func->NativeStruct->Name });
+		if (it != NativeByName.end() && it->second)
+			return &it->second;
+	}
+	throw std::runtime_error("Unknown native function " + func->NativeStruct->Name.ToString() + "." + func->Name.ToString());
+}
@@ -1,13 +1,28 @@
 #pragma once
 
 #include "ExpressionValue.h"
-#include <functional>
+#include <utility>
 
 class UObject;
 class UFunction;
-class ExpressionValue;
 
-typedef std::function<void(UObject* self, ExpressionValue* Args)> NativeFuncHandler;
+// Native function pointer plus a per-signature thunk that unpacks the arguments before calling it
+class NativeFuncHandler
+{
+public:
+	typedef void(*FuncPtr)();
+	typedef void(*ThunkPtr)(FuncPtr func, UObject* self, ArgSpan args);
+
+	NativeFuncHandler() = default;
+	NativeFuncHandler(ThunkPtr thunk, FuncPtr func) : Thunk(thunk), Func(func) {}
+
+	void operator()(UObject* self, ArgSpan args) const { Thunk(Func, self, args); }
+	explicit operator bool() const { return Thunk != nullptr; }
+
+private:
+	ThunkPtr Thunk = nullptr;
+	FuncPtr Func = nullptr;
+};
 
 class NativeFunctions
 {
@@ -18,204 +33,174 @@ public:
 
 	static void RegisterHandler(const NameString& className, const NameString& funcName, int nativeIndex, NativeFuncHandler handler);
 	static void RegisterNativeFunc(UFunction* func);
+	static const NativeFuncHandler* FindHandler(UFunction* func);
+};
+
+template<typename... Args>
+class NativeThunk
+{
+public:
+	typedef void(*StaticFunc)(Args...);
+	typedef void(*InstanceFunc)(UObject* self, Args...);
+
+	static NativeFuncHandler Create(StaticFunc func) { return NativeFuncHandler(&CallStatic, reinterpret_cast<NativeFuncHandler::FuncPtr>(func)); }
+	static NativeFuncHandler Create(InstanceFunc func) { return NativeFuncHandler(&CallInstance, reinterpret_cast<NativeFuncHandler::FuncPtr>(func)); }
+
+private:
+	static void CallStatic(NativeFuncHandler::FuncPtr func, UObject* self, ArgSpan args)
+	{
+		CallStatic(reinterpret_cast<StaticFunc>(func), args, std::index_sequence_for<Args...>());
+	}
+
+	static void CallInstance(NativeFuncHandler::FuncPtr func, UObject* self, ArgSpan args)
+	{
+		CallInstance(reinterpret_cast<InstanceFunc>(func), self, args, std::index_sequence_for<Args...>());
+	}
+
+	template<size_t... I>
+	static void CallStatic(StaticFunc func, [[maybe_unused]] ArgSpan args, std::index_sequence<I...>)
+	{
+		func(args[I].ToType<Args>()...);
+	}
+
+	template<size_t... I>
+	static void CallInstance(InstanceFunc func, UObject* self, [[maybe_unused]] ArgSpan args, std::index_sequence<I...>)
+	{
+		func(self, args[I].ToType<Args>()...);
+	}
 };
 
 // Static native functions:
 
 inline void RegisterVMNativeFunc_0(const std::string& className, const std::string& funcName, void(*func)(), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func();
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<>::Create(func));
 }
 
 template<typename Arg1>
 void RegisterVMNativeFunc_1(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1>::Create(func));
 }
 
 template<typename Arg1, typename Arg2>
 void RegisterVMNativeFunc_2(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1, Arg2 arg2), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3>
 void RegisterVMNativeFunc_3(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1, Arg2 arg2, Arg3 arg3), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4>
 void RegisterVMNativeFunc_4(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5>
 void RegisterVMNativeFunc_5(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6>
 void RegisterVMNativeFunc_6(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6, typename Arg7>
 void RegisterVMNativeFunc_7(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>(), Args[6].ToType<Arg7>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6, typename Arg7, typename Arg8>
 void RegisterVMNativeFunc_8(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7, Arg8 arg8), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>(), Args[6].ToType<Arg7>(), Args[7].ToType<Arg8>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6, typename Arg7, typename Arg8, typename Arg9>
 void RegisterVMNativeFunc_9(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7, Arg8 arg8, Arg9 arg9), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>(), Args[6].ToType<Arg7>(), Args[7].ToType<Arg8>(), Args[8].ToType<Arg9>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8, Arg9>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6, typename Arg7, typename Arg8, typename Arg9, typename Arg10>
 void RegisterVMNativeFunc_10(const std::string& className, const std::string& funcName, void(*func)(Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7, Arg8 arg8, Arg9 arg9, Arg10 arg10), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>(), Args[6].ToType<Arg7>(), Args[7].ToType<Arg8>(), Args[8].ToType<Arg9>(), Args[9].ToType<Arg10>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8, Arg9, Arg10>::Create(func));
 }
 
+
 // Instance native functions:
 
 inline void RegisterVMNativeFunc_0(const std::string& className, const std::string& funcName, void(*func)(UObject* self), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self);
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<>::Create(func));
 }
 
 template<typename Arg1>
 void RegisterVMNativeFunc_1(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1>::Create(func));
 }
 
 template<typename Arg1, typename Arg2>
 void RegisterVMNativeFunc_2(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1, Arg2 arg2), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3>
 void RegisterVMNativeFunc_3(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1, Arg2 arg2, Arg3 arg3), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4>
 void RegisterVMNativeFunc_4(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5>
 void RegisterVMNativeFunc_5(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6>
 void RegisterVMNativeFunc_6(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6, typename Arg7>
 void RegisterVMNativeFunc_7(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>(), Args[6].ToType<Arg7>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6, typename Arg7, typename Arg8>
 void RegisterVMNativeFunc_8(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7, Arg8 arg8), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>(), Args[6].ToType<Arg7>(), Args[7].ToType<Arg8>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6, typename Arg7, typename Arg8, typename Arg9>
 void RegisterVMNativeFunc_9(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7, Arg8 arg8, Arg9 arg9), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>(), Args[6].ToType<Arg7>(), Args[7].ToType<Arg8>(), Args[8].ToType<Arg9>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8, Arg9>::Create(func));
 }
 
 template<typename Arg1, typename Arg2, typename Arg3, typename Arg4, typename Arg5, typename Arg6, typename Arg7, typename Arg8, typename Arg9, typename Arg10>
 void RegisterVMNativeFunc_10(const std::string& className, const std::string& funcName, void(*func)(UObject* self, Arg1 arg1, Arg2 arg2, Arg3 arg3, Arg4 arg4, Arg5 arg5, Arg6 arg6, Arg7 arg7, Arg8 arg8, Arg9 arg9, Arg10 arg10), int nativeIndex)
 {
-	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, [=](UObject* self, ExpressionValue* Args)
-	{
-		func(self, Args[0].ToType<Arg1>(), Args[1].ToType<Arg2>(), Args[2].ToType<Arg3>(), Args[3].ToType<Arg4>(), Args[4].ToType<Arg5>(), Args[5].ToType<Arg6>(), Args[6].ToType<Arg7>(), Args[7].ToType<Arg8>(), Args[8].ToType<Arg9>(), Args[9].ToType<Arg10>());
-	});
+	NativeFunctions::RegisterHandler(className, funcName, nativeIndex, NativeThunk<Arg1, Arg2, Arg3, Arg4, Arg5, Arg6, Arg7, Arg8, Arg9, Arg10>::Create(func));
 }
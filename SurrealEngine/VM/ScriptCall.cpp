@@ -60,38 +60,46 @@ bool NameStringToEventName(const NameString& name, EventName& eventName)
 	return true;
 }
 
-ExpressionValue CallEvent(UObject* Context, EventName eventname, std::vector<ExpressionValue> args)
+ExpressionValue CallEvent(UObject* Context, EventName eventname, ArgSpan args)
 {
 	if (!Context->IsEventEnabled(eventname))
 		return ExpressionValue::NothingValue();
 
-	UFunction* func = FindEventFunction(Context, ToNameString(eventname));
+	UFunction* func = Context->GetEventFunction(eventname);
 	if (func)
-		return Frame::Call(func, Context, std::move(args));
+		return Frame::Call(func, Context, args);
 	else
 		return ExpressionValue::NothingValue();
 }
 
-ExpressionValue CallEvent(UObject* Context, const NameString& name, std::vector<ExpressionValue> args)
+ExpressionValue CallEvent(UObject* Context, const NameString& name, ArgSpan args)
 {
 	if (!Context->IsEventEnabled(name))
 		return ExpressionValue::NothingValue();
 
 	UFunction* func = FindEventFunction(Context, name);
 	if (func)
-		return Frame::Call(func, Context, std::move(args));
+		return Frame::Call(func, Context, args);
 	else
 		return ExpressionValue::NothingValue();
 }
 
 UFunction* FindEventFunction(UObject* Context, const NameString& name)
+{
+	EventName eventName = {};
+	if (NameStringToEventName(name, eventName))
+		return Context->GetEventFunction(eventName);
+	else
+		return FindEventFunction(Context->Class, Context->GetStateName(), name);
+}
+
+UFunction* FindEventFunction(UClass* contextClass, const NameString& stateName, const NameString& name)
 {
 	// Search states first
 
-	NameString stateName = Context->GetStateName();
 	if (!stateName.IsNone())
 	{
-		for (UClass* cls = Context->Class; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
+		for (UClass* cls = contextClass; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
 		{
 			UState* state = cls->GetState(stateName);
 			if (state)
@@ -107,7 +115,7 @@ UFunction* FindEventFunction(UObject* Context, const NameString& name)
 
 	// Search normal member functions next
 
-	for (UClass* cls = Context->Class; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
+	for (UClass* cls = contextClass; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
 	{
 		UFunction* func = cls->GetFunction(name);
 		if (func)
@@ -118,3 +126,56 @@ UFunction* FindEventFunction(UObject* Context, const NameString& name)
 
 	return nullptr;
 }
+
+UFunction* FindVirtualFunction(UObject* Context, const NameString& name)
+{
+	UClass* contextClass = dynamic_cast<UClass*>(Context);
+	if (!contextClass)
+		contextClass = Context->Class;
+
+	// Search states first
+
+	NameString stateName = Context->GetStateName();
+	for (UClass* cls = contextClass; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
+	{
+		UState* state = cls->GetState(stateName);
+		if (state)
+		{
+			UFunction* func = state->GetFunction(name);
+			if (func)
+				return func;
+		}
+	}
+
+	// Search normal member functions next
+
+	for (UClass* cls = contextClass; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
+	{
+		for (UField* field = cls->Children; field != nullptr; field = field->Next)
+		{
+			UFunction* func = UObject::TryCast<UFunction>(field);
+			if (func && func->Name == name)
+				return func;
+		}
+	}
+
+	return nullptr;
+}
+
+UFunction* FindGlobalFunction(UObject* Context, const NameString& name)
+{
+	// Global function calls skip the states and only searches normal member functions
+
+	UClass* contextClass = dynamic_cast<UClass*>(Context);
+	if (!contextClass)
+		contextClass = Context->Class;
+
+	for (UClass* cls = contextClass; cls != nullptr; cls = static_cast<UClass*>(cls->BaseStruct))
+	{
+		UFunction* func = cls->GetFunction(name);
+		if (func)
+			return func;
+	}
+
+	return nullptr;
+}
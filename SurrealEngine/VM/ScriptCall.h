@@ -36,10 +36,13 @@ enum class EventName
 	MaxEventNameValue // Why isn't this part of C++ after 40+ years of people doing this in both C and C++?
 };
 
-ExpressionValue CallEvent(UObject* Context, EventName name, std::vector<ExpressionValue> args = {});
-ExpressionValue CallEvent(UObject* Context, const NameString& name, std::vector<ExpressionValue> args = {});
+ExpressionValue CallEvent(UObject* Context, EventName name, ArgSpan args = {});
+ExpressionValue CallEvent(UObject* Context, const NameString& name, ArgSpan args = {});
 
 UFunction* FindEventFunction(UObject* Context, const NameString& name);
+UFunction* FindEventFunction(UClass* cls, const NameString& stateName, const NameString& name);
+UFunction* FindVirtualFunction(UObject* Context, const NameString& name);
+UFunction* FindGlobalFunction(UObject* Context, const NameString& name);
 
 NameString ToNameString(EventName name);
 bool NameStringToEventName(const NameString& name, EventName& eventName);
@@ -0,0 +1,225 @@
+
+#include "Precomp.h"
+#include "ScriptProfiler.h"
+#include "File.h"
+#include "UObject/UClass.h"
+#include <chrono>
+
+bool ScriptProfiler::Enabled = false;
+int ScriptProfiler::Session = 0;
+
+struct ScriptProfileKey
+{
+	std::string Name; // Captured on first sight, as the function may be unloaded before the report is made
+	uint64_t Calls = 0;
+	uint64_t Inclusive = 0;
+	uint64_t Exclusive = 0;
+	int Depth = 0; // Recursive calls only count towards the inclusive time once
+};
+
+struct ScriptProfileNode
+{
+	int Key = -1;
+	int Parent = -1;
+	std::map<int, int> Children;
+	uint64_t Calls = 0;
+	uint64_t Inclusive = 0;
+	uint64_t Exclusive = 0;
+};
+
+struct ScriptProfileStackEntry
+{
+	int Node = 0;
+	uint64_t StartTime = 0;
+	uint64_t ChildTime = 0;
+};
+
+struct ScriptProfileData
+{
+	std::vector<ScriptProfileKey> Keys;
+	std::map<std::pair<UFunction*, NameString>, int> KeyIndex; // Cleared when a package is unloaded
+	std::unordered_map<std::string, int> NameIndex;
+	std::vector<ScriptProfileNode> Nodes = std::vector<ScriptProfileNode>(1);
+	std::vector<ScriptProfileStackEntry> Stack;
+};
+
+static ScriptProfileData& GetData()
+{
+	static ScriptProfileData data;
+	return data;
+}
+
+static uint64_t GetProfileTime()
+{
+	using namespace std::chrono;
+	return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string GetFunctionName(UFunction* func, const NameString& state)
+{
+	std::string name;
+	for (UStruct* s = func; s != nullptr; s = s->StructParent)
+	{
+		if (name.empty())
+			name = s->Name.ToString();
+		else
+			name = s->Name.ToString() + "." + name;
+	}
+	if (AllFlags(func->FuncFlags, FunctionFlags::Native))
+		name += " [native]";
+	if (!state.IsNone())
+		name += " (" + state.ToString() + ")";
+	return name;
+}
+
+void ScriptProfiler::Start()
+{
+	GetData() = {};
+	Session++;
+	Enabled = true;
+}
+
+void ScriptProfiler::Stop()
+{
+	Enabled = false;
+}
+
+void ScriptProfiler::ForgetFunctions()
+{
+	// A function loaded later may get the address of an unloaded one
+	GetData().KeyIndex.clear();
+}
+
+void ScriptProfiler::Enter(UFunction* func, UObject* self)
+{
+	ScriptProfileData& data = GetData();
+
+	std::pair<UFunction*, NameString> id(func, self ? self->GetStateName() : NameString());
+	auto itKey = data.KeyIndex.find(id);
+	int key;
+	if (itKey == data.KeyIndex.end())
+	{
+		std::string name = GetFunctionName(func, id.second);
+		auto itName = data.NameIndex.find(name);
+		if (itName == data.NameIndex.end())
+		{
+			key = (int)data.Keys.size();
+			data.Keys.push_back({});
+			data.Keys.back().Name = name;
+			data.NameIndex[name] = key;
+		}
+		else
+		{
+			key = itName->second;
+		}
+		data.KeyIndex[id] = key;
+	}
+	else
+	{
+		key = itKey->second;
+	}
+
+	int parent = data.Stack.empty() ? 0 : data.Stack.back().Node;
+	auto itNode = data.Nodes[parent].Children.find(key);
+	int node;
+	if (itNode == data.Nodes[parent].Children.end())
+	{
+		node = (int)data.Nodes.size();
+		data.Nodes.push_back({});
+		data.Nodes.back().Key = key;
+		data.Nodes.back().Parent = parent;
+		data.Nodes[parent].Children[key] = node;
+	}
+	else
+	{
+		node = itNode->second;
+	}
+
+	data.Keys[key].Calls++;
+	data.Keys[key].Depth++;
+	data.Nodes[node].Calls++;
+
+	ScriptProfileStackEntry entry;
+	entry.Node = node;
+	entry.StartTime = GetProfileTime();
+	data.Stack.push_back(entry);
+}
+
+void ScriptProfiler::Leave()
+{
+	ScriptProfileData& data = GetData();
+	if (data.Stack.empty())
+		return;
+
+	ScriptProfileStackEntry entry = data.Stack.back();
+	data.Stack.pop_back();
+
+	uint64_t elapsed = GetProfileTime() - entry.StartTime;
+	uint64_t exclusive = elapsed - std::min(entry.ChildTime, elapsed);
+
+	ScriptProfileNode& node = data.Nodes[entry.Node];
+	node.Inclusive += elapsed;
+	node.Exclusive += exclusive;
+
+	ScriptProfileKey& key = data.Keys[node.Key];
+	key.Depth--;
+	if (key.Depth == 0)
+		key.Inclusive += elapsed;
+	key.Exclusive += exclusive;
+
+	if (!data.Stack.empty())
+		data.Stack.back().ChildTime += elapsed;
+}
+
+std::vector<std::string> ScriptProfiler::GetReport(size_t maxLines)
+{
+	ScriptProfileData& data = GetData();
+
+	std::vector<const ScriptProfileKey*> keys;
+	for (const ScriptProfileKey& key : data.Keys)
+		keys.push_back(&key);
+	std::sort(keys.begin(), keys.end(), [](const ScriptProfileKey* a, const ScriptProfileKey* b) { return a->Exclusive > b->Exclusive; });
+	if (keys.size() > maxLines)
+		keys.resize(maxLines);
+
+	std::vector<std::string> lines;
+	lines.push_back("Calls, inclusive ms, exclusive ms, function");
+	for (const ScriptProfileKey* key : keys)
+	{
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), "%llu, %.3f, %.3f, ", (unsigned long long)key->Calls, key->Inclusive / 1'000'000.0, key->Exclusive / 1'000'000.0);
+		lines.push_back(buffer + key->Name);
+	}
+	return lines;
+}
+
+void ScriptProfiler::SaveCollapsedStacks(const std::string& filename)
+{
+	// One "caller;callee;... microseconds" line per call path, as expected by flamegraph.pl and compatible tools
+	ScriptProfileData& data = GetData();
+	std::string text;
+	std::function<void(int, const std::string&)> writeNode;
+	writeNode = [&](int index, const std::string& path)
+	{
+		const ScriptProfileNode& node = data.Nodes[index];
+		std::string name = data.Keys[node.Key].Name;
+		for (char& c : name)
+		{
+			if (c == ';' || c == ' ')
+				c = '_';
+		}
+		std::string nodePath = path.empty() ? name : path + ";" + name;
+
+		uint64_t microseconds = node.Exclusive / 1000;
+		if (microseconds > 0)
+			text += nodePath + " " + std::to_string(microseconds) + "\n";
+
+		for (auto& it : node.Children)
+			writeNode(it.second, nodePath);
+	};
+
+	for (auto& it : data.Nodes[0].Children)
+		writeNode(it.second, {});
+
+	File::write_all_text(filename, text);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Package/NameString.h"
+
+class UObject;
+class UFunction;
+
+// Instrumenting profiler for script and native function calls made through Frame::Call.
+// Time is recorded per function and the state the object was in, both as a flat list and as a call tree.
+class ScriptProfiler
+{
+public:
+	static void Start();
+	static void Stop();
+	static void ForgetFunctions(); // Must be called when a package is unloaded
+	static bool IsEnabled() { return Enabled; }
+
+	static std::vector<std::string> GetReport(size_t maxLines);
+	static void SaveCollapsedStacks(const std::string& filename);
+
+private:
+	static void Enter(UFunction* func, UObject* self);
+	static void Leave();
+
+	static bool Enabled;
+	static int Session;
+
+	friend class ScriptProfileScope;
+};
+
+class ScriptProfileScope
+{
+public:
+	ScriptProfileScope(UFunction* func, UObject* self)
+	{
+		if (ScriptProfiler::Enabled)
+		{
+			Session = ScriptProfiler::Session;
+			ScriptProfiler::Enter(func, self);
+		}
+	}
+
+	~ScriptProfileScope()
+	{
+		if (Session != -1 && Session == ScriptProfiler::Session)
+			ScriptProfiler::Leave();
+	}
+
+private:
+	ScriptProfileScope(const ScriptProfileScope&) = delete;
+	ScriptProfileScope& operator=(const ScriptProfileScope&) = delete;
+
+	int Session = -1;
+};
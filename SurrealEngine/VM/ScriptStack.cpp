@@ -0,0 +1,34 @@
+
+#include "Precomp.h"
+#include "ScriptStack.h"
+
+ScriptStack& ScriptStack::Get()
+{
+	static thread_local ScriptStack stack;
+	return stack;
+}
+
+ScriptStack::ScriptStack()
+{
+	Values = std::make_unique<ExpressionValue[]>(ValueCapacity);
+	Memory = std::make_unique<uint64_t[]>(MemoryCapacity);
+}
+
+ExpressionValue* ScriptStack::PushValues(size_t count)
+{
+	if (ValueTop + count > ValueCapacity)
+		throw std::runtime_error("Script stack overflow");
+	ExpressionValue* values = Values.get() + ValueTop;
+	ValueTop += count;
+	return values;
+}
+
+void* ScriptStack::PushMemory(size_t size)
+{
+	size_t count = (size + 7) / 8;
+	if (MemoryTop + count > MemoryCapacity)
+		throw std::runtime_error("Script stack overflow");
+	uint64_t* data = Memory.get() + MemoryTop;
+	MemoryTop += count;
+	return data;
+}
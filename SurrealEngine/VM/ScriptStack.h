@@ -0,0 +1,58 @@
+#pragma once
+
+#include "ExpressionValue.h"
+
+// Per-thread stack memory for script calls. Holds argument values, interpreter registers and local variables
+// so that calling a script or native function doesn't need to allocate anything on the heap.
+class ScriptStack
+{
+public:
+	static ScriptStack& Get();
+
+	ExpressionValue* PushValues(size_t count);
+	void PopValues(size_t count) { ValueTop -= count; }
+
+	void* PushMemory(size_t size);
+	void PopMemory(size_t size) { MemoryTop -= (size + 7) / 8; }
+
+private:
+	ScriptStack();
+
+	enum { ValueCapacity = 64 * 1024, MemoryCapacity = 1024 * 1024 };
+
+	std::unique_ptr<ExpressionValue[]> Values;
+	std::unique_ptr<uint64_t[]> Memory;
+	size_t ValueTop = 0;
+	size_t MemoryTop = 0;
+};
+
+class ScriptStackValues
+{
+public:
+	ScriptStackValues(size_t count) : Count(count) { Values = ScriptStack::Get().PushValues(Count); }
+	~ScriptStackValues() { ScriptStack::Get().PopValues(Count); }
+
+	ExpressionValue& operator[](size_t index) { return Values[index]; }
+	ArgSpan Span() { return ArgSpan(Values, Count); }
+
+	ExpressionValue* Values = nullptr;
+	size_t Count = 0;
+
+private:
+	ScriptStackValues(const ScriptStackValues&) = delete;
+	ScriptStackValues& operator=(const ScriptStackValues&) = delete;
+};
+
+class ScriptStackMemory
+{
+public:
+	ScriptStackMemory(size_t size) : Size(size) { Data = ScriptStack::Get().PushMemory(Size); }
+	~ScriptStackMemory() { ScriptStack::Get().PopMemory(Size); }
+
+	void* Data = nullptr;
+	size_t Size = 0;
+
+private:
+	ScriptStackMemory(const ScriptStackMemory&) = delete;
+	ScriptStackMemory& operator=(const ScriptStackMemory&) = delete;
+};